@@ -0,0 +1,458 @@
+#include "argsort.h"
+
+#include "huge_alloc.h"
+#include "pivot.h"
+#include "sorting_statistics.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SMALL_SORT_CUTOFF 16 // Ranges of at most this many words are insertion sorted.
+#define MAX_RANGES        64 // Enough pending ranges for any array, since the smaller side is always sorted first.
+#define GATHER_PREFETCH   16 // How many rows ahead the gather prefetches.
+#define GATHER_MIN_ROWS   ( 1 << 16 ) // Gathers with fewer rows than this stay on the calling thread.
+
+#ifndef LARGE_BLOCK
+#define LARGE_BLOCK ( ( size_t ) INT32_MAX ) // The most keys argsort_large( ) argsorts at once with packed words.
+#endif
+
+static uint32_t thread_count = 1;
+
+// Description:
+// A slice of a gather done by one thread.
+//
+// Members:
+// const uint8_t *rows - The rows to gather from.
+// size_t row_size - The size of each row in bytes.
+// const uint32_t *perm - The row each output row is copied from.
+// uint8_t *out - The rows to gather into.
+// uint32_t lo - The first output row of the slice.
+// uint32_t hi - One past the last output row of the slice.
+typedef struct {
+	const uint8_t *rows;
+	size_t row_size;
+	const uint32_t *perm;
+	uint8_t *out;
+	uint32_t lo;
+	uint32_t hi;
+} GatherTask;
+
+// Description:
+// Packs a key and its index into one word that orders by key, then by index.
+//
+// Parameters:
+// uint32_t key - The key.
+// uint32_t index - The index of the key.
+//
+// Returns:
+// uint64_t - The packed word.
+static inline uint64_t pack_word( uint32_t key, uint32_t index ) {
+	return ( ( uint64_t ) key << 32 ) | index;
+}
+
+// Description:
+// Sorts a small range of words with insertion sort.
+//
+// Parameters:
+// uint64_t *words - The words to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void insertion_sort( uint64_t *words, int64_t lo, int64_t hi, SortingStatistics *stats ) {
+	for ( int64_t i = lo + 1; i <= hi; i++ ) {
+		int64_t j = i;
+		uint64_t temp = words[ i ];
+
+		while ( j > lo && ++stats->compares && temp < words[ j - 1 ] ) {
+			words[ j ] = words[ j - 1 ];
+			stats->moves++;
+			j -= 1;
+		}
+
+		words[ j ] = temp;
+		stats->moves += 2;
+	}
+}
+
+// Description:
+// Partitions a range of words around the median of its first, middle and last words. Words are
+// unique, so the median is never the largest word and both sides always shrink.
+//
+// Parameters:
+// uint64_t *words - The words to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// int64_t - The division of the range.
+static int64_t partition( uint64_t *words, int64_t lo, int64_t hi, SortingStatistics *stats ) {
+	uint64_t pivot = median_of_three_words( words[ lo ], words[ lo + ( ( hi - lo ) / 2 ) ], words[ hi ] );
+	int64_t i = lo - 1;
+	int64_t j = hi + 1;
+	stats->compares += MEDIAN_OF_THREE_COMPARES;
+
+	while ( i < j ) {
+		i += 1;
+
+		while ( ++stats->compares && words[ i ] < pivot ) {
+			i += 1;
+		}
+
+		j -= 1;
+
+		while ( ++stats->compares && words[ j ] > pivot ) {
+			j -= 1;
+		}
+
+		if ( i < j ) {
+			// Swap words[i] and words[j].
+			uint64_t old_word_i = words[ i ];
+			words[ i ] = words[ j ];
+			words[ j ] = old_word_i;
+			stats->moves += 3;
+		}
+	}
+
+	return j;
+}
+
+// Description:
+// Sorts words with quicksort, always sorting the smaller side of a partition first so that at most
+// log2( len ) ranges are ever pending.
+//
+// Parameters:
+// uint64_t *words - The words to sort.
+// uint32_t len - The number of words.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void sort_words( uint64_t *words, uint32_t len, SortingStatistics *stats ) {
+	int64_t pending[ MAX_RANGES ][ 2 ];
+	uint32_t count = 0;
+	int64_t lo = 0;
+	int64_t hi = ( int64_t ) len - 1;
+
+	while ( true ) {
+		while ( hi - lo + 1 > SMALL_SORT_CUTOFF ) {
+			int64_t p = partition( words, lo, hi, stats );
+
+			// Defer the larger side and keep splitting the smaller one.
+			if ( p - lo < hi - p ) {
+				pending[ count ][ 0 ] = p + 1;
+				pending[ count ][ 1 ] = hi;
+				hi = p;
+			} else {
+				pending[ count ][ 0 ] = lo;
+				pending[ count ][ 1 ] = p;
+				lo = p + 1;
+			}
+
+			count++;
+
+			if ( count > stats->max_ds_size ) {
+				stats->max_ds_size = count;
+			}
+		}
+
+		insertion_sort( words, lo, hi, stats );
+
+		if ( count == 0 ) {
+			return;
+		}
+
+		count--;
+		lo = pending[ count ][ 0 ];
+		hi = pending[ count ][ 1 ];
+	}
+}
+
+// Description:
+// Sets the number of threads argsort_gather( ) uses.
+//
+// Parameters:
+// uint32_t threads - The number of threads (at least 1).
+//
+// Returns:
+// Nothing.
+void argsort_set_thread_count( uint32_t threads ) {
+	thread_count = threads > 0 ? threads : 1;
+}
+
+// Description:
+// Finds the permutation that sorts an array of keys without moving the keys. Each key is packed
+// with its index into a 64-bit word and the words are sorted, so partitions move 8 bytes per
+// element no matter how wide the rows the keys belong to are. Equal keys keep their input order.
+//
+// Parameters:
+// const uint32_t *keys - The keys to sort by.
+// uint32_t len - The number of keys.
+// uint32_t *perm - Set to the index of the key that belongs at each position of the sorted order.
+// SortingStatistics *stats - Set to the statistics for the sort (moves and compares are of words).
+//
+// Returns:
+// bool - Whether the sort succeeded (false if the words could not be allocated).
+bool argsort( const uint32_t *keys, uint32_t len, uint32_t *perm, SortingStatistics *stats ) {
+	*stats = sorting_statistics_create( len );
+
+	if ( len == 0 ) {
+		return true;
+	}
+
+	uint64_t *words = ( uint64_t * ) malloc( ( size_t ) len * sizeof( uint64_t ) );
+
+	if ( !words ) {
+		return false;
+	}
+
+	for ( uint32_t i = 0; i < len; i++ ) {
+		words[ i ] = pack_word( keys[ i ], i );
+	}
+
+	sort_words( words, len, stats );
+
+	for ( uint32_t i = 0; i < len; i++ ) {
+		perm[ i ] = ( uint32_t ) words[ i ];
+	}
+
+	free( words );
+
+	return true;
+}
+
+// Description:
+// Copies the rows of one slice of a gather. The common row sizes get their own loops so that the
+// copies compile to single loads and stores.
+//
+// Parameters:
+// void *arg - A pointer to the GatherTask.
+//
+// Returns:
+// void * - NULL.
+static void *gather_slice( void *arg ) {
+	GatherTask *task = ( GatherTask * ) arg;
+	const uint8_t *rows = task->rows;
+	const uint32_t *perm = task->perm;
+	uint8_t *out = task->out;
+	size_t size = task->row_size;
+
+	for ( uint32_t i = task->lo; i < task->hi; i++ ) {
+		if ( i + GATHER_PREFETCH < task->hi ) { // The source rows are scattered, so fetch them early.
+			__builtin_prefetch( rows + ( size_t ) perm[ i + GATHER_PREFETCH ] * size );
+		}
+
+		switch ( size ) {
+		case 4: memcpy( out + ( size_t ) i * 4, rows + ( size_t ) perm[ i ] * 4, 4 ); break;
+		case 8: memcpy( out + ( size_t ) i * 8, rows + ( size_t ) perm[ i ] * 8, 8 ); break;
+		default: memcpy( out + ( size_t ) i * size, rows + ( size_t ) perm[ i ] * size, size ); break;
+		}
+	}
+
+	return NULL;
+}
+
+// Description:
+// Materializes rows in sorted order in one pass, so each row is moved exactly once. The output is
+// split into contiguous slices, one per thread, and slices whose thread cannot be started are
+// copied on the calling thread.
+//
+// Parameters:
+// const void *rows - The rows to gather from.
+// size_t row_size - The size of each row in bytes.
+// const uint32_t *perm - The row each output row is copied from, as set by argsort( ).
+// uint32_t len - The number of rows.
+// void *out - The rows to gather into. Must not overlap rows.
+//
+// Returns:
+// Nothing.
+void argsort_gather( const void *rows, size_t row_size, const uint32_t *perm, uint32_t len, void *out ) {
+	uint32_t threads = len < GATHER_MIN_ROWS ? 1 : thread_count;
+	GatherTask *tasks = ( GatherTask * ) calloc( threads, sizeof( GatherTask ) );
+	pthread_t *handles = ( pthread_t * ) calloc( threads, sizeof( pthread_t ) );
+	bool *started = ( bool * ) calloc( threads, sizeof( bool ) );
+
+	if ( !tasks || !handles || !started ) {
+		GatherTask task = { .rows = rows, .row_size = row_size, .perm = perm, .out = out, .lo = 0, .hi = len };
+		gather_slice( &task );
+		free( tasks );
+		free( handles );
+		free( started );
+
+		return;
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		tasks[ t ].rows = rows;
+		tasks[ t ].row_size = row_size;
+		tasks[ t ].perm = perm;
+		tasks[ t ].out = out;
+		tasks[ t ].lo = ( uint32_t ) ( ( uint64_t ) len * t / threads );
+		tasks[ t ].hi = ( uint32_t ) ( ( uint64_t ) len * ( t + 1 ) / threads );
+	}
+
+	for ( uint32_t t = 1; t < threads; t++ ) {
+		started[ t ] = pthread_create( &handles[ t ], NULL, gather_slice, &tasks[ t ] ) == 0;
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		if ( started[ t ] ) {
+			pthread_join( handles[ t ], NULL );
+		} else {
+			gather_slice( &tasks[ t ] );
+		}
+	}
+
+	free( tasks );
+	free( handles );
+	free( started );
+}
+
+// Description:
+// Compares the next keys of two blocks being merged by argsort_large( ). Ties go to the earlier block,
+// which keeps equal keys in their input order.
+//
+// Parameters:
+// const uint32_t *keys - The keys.
+// const uint32_t *runs - The permutation of each block, relative to the start of the block.
+// const size_t *next - The position in runs of the next key of each block.
+// uint32_t a - The first block.
+// uint32_t b - The second block.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// bool - Whether the next key of block a goes before the next key of block b.
+static bool block_before( const uint32_t *keys, const uint32_t *runs, const size_t *next, uint32_t a, uint32_t b, SortingStatistics *stats ) {
+	uint32_t key_a = keys[ a * LARGE_BLOCK + runs[ next[ a ] ] ];
+	uint32_t key_b = keys[ b * LARGE_BLOCK + runs[ next[ b ] ] ];
+	stats->compares++;
+
+	return key_a < key_b || ( key_a == key_b && a < b );
+}
+
+// Description:
+// Moves the block at the root of a heap of blocks down until the heap is ordered again.
+//
+// Parameters:
+// uint32_t *heap - The blocks, ordered by their next keys.
+// uint32_t heap_len - The number of blocks in the heap.
+// const uint32_t *keys - The keys.
+// const uint32_t *runs - The permutation of each block, relative to the start of the block.
+// const size_t *next - The position in runs of the next key of each block.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void sift_down( uint32_t *heap, uint32_t heap_len, const uint32_t *keys, const uint32_t *runs, const size_t *next, SortingStatistics *stats ) {
+	uint32_t i = 0;
+
+	while ( 2 * i + 1 < heap_len ) {
+		uint32_t child = 2 * i + 1;
+
+		if ( child + 1 < heap_len && block_before( keys, runs, next, heap[ child + 1 ], heap[ child ], stats ) ) {
+			child++;
+		}
+
+		if ( !block_before( keys, runs, next, heap[ child ], heap[ i ], stats ) ) {
+			return;
+		}
+
+		uint32_t temp = heap[ i ];
+		heap[ i ] = heap[ child ];
+		heap[ child ] = temp;
+		stats->moves += 3;
+		i = child;
+	}
+}
+
+// Description:
+// Finds the permutation that sorts an array of keys of any length, like argsort( ) but with 64-bit indices.
+// Arrays that fit are argsorted with packed words directly. Longer ones are argsorted in blocks of
+// LARGE_BLOCK keys, and the blocks are merged through a heap. Equal keys keep their input order.
+//
+// Parameters:
+// const uint32_t *keys - The keys to sort by.
+// size_t len - The number of keys.
+// uint64_t *perm - Set to the index of the key that belongs at each position of the sorted order.
+// SortingStatistics *stats - Set to the statistics for the sort.
+//
+// Returns:
+// bool - Whether the sort succeeded (false if memory could not be allocated).
+bool argsort_large( const uint32_t *keys, size_t len, uint64_t *perm, SortingStatistics *stats ) {
+	if ( len <= LARGE_BLOCK ) {
+		// The 32-bit permutation fits in the first half of perm. Widening it from the back only ever
+		// overwrites entries that were already read.
+		uint32_t *narrow = ( uint32_t * ) perm;
+
+		if ( !argsort( keys, ( uint32_t ) len, narrow, stats ) ) {
+			return false;
+		}
+
+		for ( size_t i = len; i > 0; i-- ) {
+			perm[ i - 1 ] = narrow[ i - 1 ];
+		}
+
+		return true;
+	}
+
+	*stats = sorting_statistics_create( len );
+	uint32_t blocks = ( uint32_t ) ( ( len + LARGE_BLOCK - 1 ) / LARGE_BLOCK );
+	uint32_t *runs = ( uint32_t * ) huge_alloc( len * sizeof( uint32_t ) );
+	size_t *next = ( size_t * ) calloc( blocks, sizeof( size_t ) );
+	size_t *ends = ( size_t * ) calloc( blocks, sizeof( size_t ) );
+	uint32_t *heap = ( uint32_t * ) calloc( blocks, sizeof( uint32_t ) );
+	bool ok = runs && next && ends && heap;
+
+	for ( uint32_t b = 0; ok && b < blocks; b++ ) {
+		size_t start = b * LARGE_BLOCK;
+		size_t block_len = len - start < LARGE_BLOCK ? len - start : LARGE_BLOCK;
+		SortingStatistics block_stats;
+		ok = argsort( keys + start, ( uint32_t ) block_len, runs + start, &block_stats );
+		stats->moves += block_stats.moves;
+		stats->compares += block_stats.compares;
+		next[ b ] = start;
+		ends[ b ] = start + block_len;
+	}
+
+	// Order the blocks by their first keys, sifting each one up into the heap.
+	uint32_t heap_len = 0;
+
+	for ( uint32_t b = 0; ok && b < blocks; b++ ) {
+		uint32_t i = heap_len++;
+		heap[ i ] = b;
+
+		while ( i > 0 && block_before( keys, runs, next, heap[ i ], heap[ ( i - 1 ) / 2 ], stats ) ) {
+			uint32_t temp = heap[ i ];
+			heap[ i ] = heap[ ( i - 1 ) / 2 ];
+			heap[ ( i - 1 ) / 2 ] = temp;
+			stats->moves += 3;
+			i = ( i - 1 ) / 2;
+		}
+	}
+
+	for ( size_t k = 0; ok && k < len; k++ ) {
+		uint32_t b = heap[ 0 ];
+		perm[ k ] = b * LARGE_BLOCK + runs[ next[ b ] ];
+		stats->moves++;
+
+		if ( ++next[ b ] == ends[ b ] ) { // The block is used up, so replace it with the last one.
+			heap[ 0 ] = heap[ --heap_len ];
+		}
+
+		sift_down( heap, heap_len, keys, runs, next, stats );
+	}
+
+	huge_free( runs, len * sizeof( uint32_t ) );
+	free( next );
+	free( ends );
+	free( heap );
+
+	return ok;
+}
@@ -0,0 +1,18 @@
+#ifndef __ARGSORT_H__
+#define __ARGSORT_H__
+
+#include "sorting_statistics.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+void argsort_set_thread_count( uint32_t threads );
+
+bool argsort( const uint32_t *keys, uint32_t len, uint32_t *perm, SortingStatistics *stats );
+
+void argsort_gather( const void *rows, size_t row_size, const uint32_t *perm, uint32_t len, void *out );
+
+bool argsort_large( const uint32_t *keys, size_t len, uint64_t *perm, SortingStatistics *stats );
+
+#endif
@@ -0,0 +1,189 @@
+#include "autotune.h"
+
+#include "quick.h"
+#include "shell.h"
+#include "sorting_statistics.h"
+#include "tuning.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define AUTOTUNE_REPEATS       3 // The number of times each candidate is timed (the fastest run counts).
+#define MIN_PARALLEL_THRESHOLD 1024 // The smallest array size tried as the parallel threshold.
+
+static const uint32_t cutoff_candidates[] = { 0, 8, 16, 24, 32, 48, 64 };
+
+// Description:
+// Gets the time from a monotonic clock.
+//
+// Parameters:
+// Nothing.
+//
+// Returns:
+// double - The time in seconds.
+static double now( ) {
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( double ) ts.tv_sec + ( double ) ts.tv_nsec / 1e9;
+}
+
+// Description:
+// Times a sort on copies of an input array with the active tuning profile.
+//
+// Parameters:
+// SortingStatistics ( *sort_function )( uint32_t *, uint32_t ) - The sort to time.
+// const uint32_t *input - The unsorted elements.
+// uint32_t *work - A buffer of at least len elements to sort in.
+// uint32_t len - The number of elements to sort.
+//
+// Returns:
+// double - The fastest time in seconds.
+static double time_sort( SortingStatistics ( *sort_function )( uint32_t *, uint32_t ), const uint32_t *input, uint32_t *work, uint32_t len ) {
+	double fastest = INFINITY;
+
+	for ( uint32_t i = 0; i < AUTOTUNE_REPEATS; i++ ) {
+		memcpy( work, input, len * sizeof( uint32_t ) );
+		double start = now( );
+		sort_function( work, len );
+		double elapsed = now( ) - start;
+		fastest = elapsed < fastest ? elapsed : fastest;
+	}
+
+	return fastest;
+}
+
+// Description:
+// Benchmarks candidate settings for each tunable on this machine and picks the fastest of each. Settings are
+// tuned one at a time, with every later setting benchmarked on top of the winners before it. The size
+// thresholds tuned are where quicksort hands ranges off to insertion sort and where the multi-threaded sorts
+// start using threads. Progress is printed to stdout.
+//
+// Parameters:
+// const uint32_t *input - The unsorted elements to benchmark with.
+// uint32_t len - The number of elements.
+// TuningProfile *best - A pointer to the TuningProfile to set the winning settings to.
+//
+// Returns:
+// bool - Whether the operation was successful.
+bool autotune( const uint32_t *input, uint32_t len, TuningProfile *best ) {
+	uint32_t *work = ( uint32_t * ) calloc( len, sizeof( uint32_t ) );
+
+	if ( !work ) {
+		return false;
+	}
+
+	TuningProfile profile = tuning_defaults( );
+	*best = profile;
+	double fastest = INFINITY;
+	printf( "Autotuning with %" PRIu32 " elements\n", len );
+
+	// Pivot strategy.
+	for ( pivot_strategy pivot = PIVOT_MIDDLE; pivot <= PIVOT_MEDIAN_OF_THREE; pivot++ ) {
+		TuningProfile candidate = profile;
+		candidate.pivot = pivot;
+		tuning_set( &candidate );
+		double elapsed = time_sort( quicksort_recursive, input, work, len );
+		printf( "   pivot %-18s %.6f s\n", pivot == PIVOT_MIDDLE ? "middle" : "median_of_three", elapsed );
+
+		if ( elapsed < fastest ) {
+			fastest = elapsed;
+			best->pivot = pivot;
+		}
+	}
+
+	profile.pivot = best->pivot;
+	fastest = INFINITY;
+
+	// Small-sort cutoff.
+	for ( uint32_t i = 0; i < sizeof( cutoff_candidates ) / sizeof( cutoff_candidates[ 0 ] ); i++ ) {
+		TuningProfile candidate = profile;
+		candidate.small_sort_cutoff = cutoff_candidates[ i ];
+		tuning_set( &candidate );
+		double elapsed = time_sort( quicksort_recursive, input, work, len );
+		printf( "   small_sort_cutoff %-6" PRIu32 " %.6f s\n", cutoff_candidates[ i ], elapsed );
+
+		if ( elapsed < fastest ) {
+			fastest = elapsed;
+			best->small_sort_cutoff = cutoff_candidates[ i ];
+		}
+	}
+
+	profile.small_sort_cutoff = best->small_sort_cutoff;
+	fastest = INFINITY;
+
+	// Gap sequence.
+	shell_set_gap_sequence( NULL, 0 ); // Make shell sort use the gap sequence from the profile.
+
+	for ( gap_sequence gaps = GAP_SEQ_CIURA; gaps <= GAP_SEQ_PRATT; gaps++ ) {
+		TuningProfile candidate = profile;
+		candidate.gaps = gaps;
+		tuning_set( &candidate );
+		double elapsed = time_sort( shell_sort, input, work, len );
+		printf( "   gap_sequence %-11s %.6f s\n", gaps == GAP_SEQ_CIURA ? "ciura" : "pratt", elapsed );
+
+		if ( elapsed < fastest ) {
+			fastest = elapsed;
+			best->gaps = gaps;
+		}
+	}
+
+	profile.gaps = best->gaps;
+	fastest = INFINITY;
+
+	// Thread count, doubling up to the number of online CPUs.
+	long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+	uint32_t max_threads = cpus > 0 ? ( uint32_t ) cpus : 1;
+
+	for ( uint32_t threads = 1; threads <= max_threads; threads = threads < max_threads && threads * 2 > max_threads ? max_threads : threads * 2 ) {
+		tuning_set( &profile ); // The parallel threshold is still 0, so every candidate uses all its threads.
+		quick_set_thread_count( threads );
+		double elapsed = time_sort( quicksort_work_stealing, input, work, len );
+		printf( "   threads %-16" PRIu32 " %.6f s\n", threads, elapsed );
+
+		if ( elapsed < fastest ) {
+			fastest = elapsed;
+			best->threads = threads;
+		}
+	}
+
+	profile.threads = best->threads;
+
+	// Parallel threshold: the smallest size from which the parallel sort beats the serial one at every size tried.
+	best->parallel_threshold = 0;
+
+	if ( profile.threads > 1 ) {
+		tuning_set( &profile );
+		quick_set_thread_count( profile.threads );
+		best->parallel_threshold = UINT32_MAX;
+
+		for ( uint64_t size = len; size >= MIN_PARALLEL_THRESHOLD; size /= 4 ) {
+			double serial = time_sort( quicksort_stack, input, work, ( uint32_t ) size );
+			double parallel = time_sort( quicksort_work_stealing, input, work, ( uint32_t ) size );
+			printf( "   parallel at %-12" PRIu64 " %.6f s (serial %.6f s)\n", size, parallel, serial );
+
+			if ( parallel >= serial ) {
+				break;
+			}
+
+			best->parallel_threshold = ( uint32_t ) size;
+		}
+
+		if ( best->parallel_threshold == UINT32_MAX ) { // Threads never paid off.
+			best->threads = 1;
+			best->parallel_threshold = 0;
+		}
+	}
+
+	tuning_set( best );
+	free( work );
+
+	return true;
+}
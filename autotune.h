@@ -0,0 +1,11 @@
+#ifndef __AUTOTUNE_H__
+#define __AUTOTUNE_H__
+
+#include "tuning.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool autotune( const uint32_t *input, uint32_t len, TuningProfile *best );
+
+#endif
@@ -2,8 +2,54 @@
 
 #include "sorting_statistics.h"
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+
+#define SWAP_COUNT_SLOTS 4 // Phases whose swap counts are kept at once by odd-even sort (see odd_even_worker( )).
+#define START_WAIT       0 // Odd-even sort threads wait until every thread has been started.
+#define START_GO         1 // Odd-even sort threads can begin sorting.
+#define START_ABORT      2 // Odd-even sort threads should exit because not every thread could be started.
+
+static uint32_t thread_count = 1;
+
+// Description:
+// Shared state for the threads of an odd-even transposition sort.
+//
+// Members:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+// uint32_t threads - The number of threads sorting the array.
+// pthread_mutex_t start_lock - Protects start_state.
+// pthread_cond_t start_changed - Signaled when start_state changes.
+// int start_state - Whether the threads should wait (START_WAIT), sort (START_GO) or exit (START_ABORT).
+// pthread_barrier_t barrier - Separates the phases of the sort.
+// _Atomic uint64_t swaps[] - The number of swaps done in recent phases, indexed by phase % SWAP_COUNT_SLOTS.
+typedef struct {
+	uint32_t *arr;
+	uint32_t len;
+	uint32_t threads;
+	pthread_mutex_t start_lock;
+	pthread_cond_t start_changed;
+	int start_state;
+	pthread_barrier_t barrier;
+	_Atomic uint64_t swaps[ SWAP_COUNT_SLOTS ];
+} OddEvenShared;
+
+// Description:
+// The work of one thread of an odd-even transposition sort.
+//
+// Members:
+// OddEvenShared *shared - The state shared by all the threads.
+// uint32_t id - The index of this thread.
+// SortingStatistics stats - The statistics for the compare-swaps done by this thread.
+typedef struct {
+	OddEvenShared *shared;
+	uint32_t id;
+	SortingStatistics stats;
+} OddEvenWorker;
 
 // Description:
 // Uses bubble sort to sort an array.
@@ -40,3 +86,272 @@ SortingStatistics bubble_sort( uint32_t *arr, uint32_t len ) {
 
 	return stats;
 }
+
+// Description:
+// Uses bubble sort to sort an array, ending each pass at the last swap of the previous pass.
+// Everything after the last swap is already in its final place, so this can skip many passes
+// on nearly-sorted arrays.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics bubble_sort_last_swap( uint32_t *arr, uint32_t len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	uint32_t pass_size = len;
+
+	while ( pass_size > 1 ) { // Continue until there is nothing else to check.
+		uint32_t last_swap = 0;
+
+		for ( uint32_t i = 1; i < pass_size; i++ ) {
+			if ( arr[ i ] < arr[ i - 1 ] ) { // Compare to previous element.
+				// Swap arr[i] and arr[i - 1].
+				uint32_t old_arr_i = arr[ i ];
+				arr[ i ] = arr[ i - 1 ];
+				arr[ i - 1 ] = old_arr_i;
+				stats.moves += 3;
+				last_swap = i;
+			}
+
+			stats.compares++;
+		}
+
+		pass_size = last_swap; // Elements from the last swap onward are sorted.
+	}
+
+	return stats;
+}
+
+// Description:
+// Uses cocktail shaker sort (bidirectional bubble sort) to sort an array.
+// Passes alternate between moving large elements up and small elements down, and both ends
+// of the unsorted range shrink to the last swap of the pass that moved them.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics cocktail_sort( uint32_t *arr, uint32_t len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	uint32_t lo = 1; // The first index compared to its previous element.
+	uint32_t hi = len; // One past the last index compared to its previous element.
+
+	while ( lo < hi ) {
+		uint32_t last_swap = 0;
+
+		// Move the largest unsorted element up.
+		for ( uint32_t i = lo; i < hi; i++ ) {
+			if ( arr[ i ] < arr[ i - 1 ] ) {
+				// Swap arr[i] and arr[i - 1].
+				uint32_t old_arr_i = arr[ i ];
+				arr[ i ] = arr[ i - 1 ];
+				arr[ i - 1 ] = old_arr_i;
+				stats.moves += 3;
+				last_swap = i;
+			}
+
+			stats.compares++;
+		}
+
+		hi = last_swap;
+
+		if ( lo >= hi ) {
+			break;
+		}
+
+		last_swap = hi;
+
+		// Move the smallest unsorted element down.
+		for ( uint32_t i = hi - 1; i >= lo; i-- ) {
+			if ( arr[ i ] < arr[ i - 1 ] ) {
+				// Swap arr[i] and arr[i - 1].
+				uint32_t old_arr_i = arr[ i ];
+				arr[ i ] = arr[ i - 1 ];
+				arr[ i - 1 ] = old_arr_i;
+				stats.moves += 3;
+				last_swap = i;
+			}
+
+			stats.compares++;
+		}
+
+		lo = last_swap + 1;
+	}
+
+	return stats;
+}
+
+// Description:
+// Sets the number of threads the next odd-even transposition sort will use.
+//
+// Parameters:
+// uint32_t threads - The number of threads to use (0 is treated as 1).
+//
+// Returns:
+// Nothing.
+void bubble_set_thread_count( uint32_t threads ) {
+	thread_count = threads > 0 ? threads : 1;
+}
+
+// Description:
+// Compare-swaps every pair of one parity in a slice of an array. The loop is branchless so that
+// it vectorizes into min/max instructions.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t first - The index of the first element of the first pair.
+// uint32_t pairs - The number of pairs to compare-swap.
+//
+// Returns:
+// uint64_t - The number of pairs that were swapped.
+static uint64_t compare_swap_pairs( uint32_t *arr, uint32_t first, uint32_t pairs ) {
+	uint32_t *pair = arr + first;
+	uint64_t swaps = 0;
+
+	for ( uint32_t q = 0; q < pairs; q++ ) {
+		uint32_t a = pair[ 2 * q ];
+		uint32_t b = pair[ 2 * q + 1 ];
+		pair[ 2 * q ] = a < b ? a : b;
+		pair[ 2 * q + 1 ] = a < b ? b : a;
+		swaps += a > b;
+	}
+
+	return swaps;
+}
+
+// Description:
+// Runs the phases of an odd-even transposition sort for one thread. Phase p compare-swaps the pairs
+// starting at indices of parity p % 2, and each thread handles a fixed slice of the pairs. The sort
+// ends after two consecutive phases without a swap. Swap counts are kept in SWAP_COUNT_SLOTS slots so
+// that the slot for phase p + 2 can be reset after phase p without racing readers of phase p - 1.
+//
+// Parameters:
+// void *arg - A pointer to the thread's OddEvenWorker.
+//
+// Returns:
+// void * - NULL.
+static void *odd_even_worker( void *arg ) {
+	OddEvenWorker *worker = ( OddEvenWorker * ) arg;
+	OddEvenShared *shared = worker->shared;
+
+	// Wait until every thread exists, since the barrier would deadlock otherwise.
+	pthread_mutex_lock( &shared->start_lock );
+
+	while ( shared->start_state == START_WAIT ) {
+		pthread_cond_wait( &shared->start_changed, &shared->start_lock );
+	}
+
+	int start_state = shared->start_state;
+	pthread_mutex_unlock( &shared->start_lock );
+
+	if ( start_state == START_ABORT ) {
+		return NULL;
+	}
+
+	for ( uint32_t phase = 0; phase <= shared->len; phase++ ) { // len phases always sort the array.
+		uint32_t parity = phase % 2;
+		uint32_t pairs = shared->len > parity ? ( shared->len - parity ) / 2 : 0;
+		uint32_t start = ( uint32_t ) ( ( uint64_t ) pairs * worker->id / shared->threads );
+		uint32_t end = ( uint32_t ) ( ( uint64_t ) pairs * ( worker->id + 1 ) / shared->threads );
+		uint64_t swaps = compare_swap_pairs( shared->arr, parity + 2 * start, end - start );
+		worker->stats.compares += end - start;
+		worker->stats.moves += 3 * swaps;
+		atomic_fetch_add_explicit( &shared->swaps[ phase % SWAP_COUNT_SLOTS ], swaps, memory_order_relaxed );
+		pthread_barrier_wait( &shared->barrier );
+
+		if ( worker->id == 0 ) {
+			atomic_store_explicit( &shared->swaps[ ( phase + 2 ) % SWAP_COUNT_SLOTS ], 0, memory_order_relaxed );
+		}
+
+		uint64_t phase_swaps = atomic_load_explicit( &shared->swaps[ phase % SWAP_COUNT_SLOTS ], memory_order_relaxed );
+		uint64_t previous_swaps = atomic_load_explicit( &shared->swaps[ ( phase + SWAP_COUNT_SLOTS - 1 ) % SWAP_COUNT_SLOTS ], memory_order_relaxed );
+
+		if ( phase > 0 && phase_swaps == 0 && previous_swaps == 0 ) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+// Description:
+// Uses odd-even transposition sort to sort an array, split across the threads set with
+// bubble_set_thread_count( ).
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics odd_even_sort( uint32_t *arr, uint32_t len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	uint32_t threads = thread_count < len / 2 ? thread_count : ( len / 2 > 0 ? len / 2 : 1 ); // Give each thread at least one pair.
+	OddEvenShared shared = { .arr = arr, .len = len, .threads = threads, .start_state = START_WAIT };
+	OddEvenWorker *workers = ( OddEvenWorker * ) calloc( threads, sizeof( OddEvenWorker ) );
+	pthread_t *handles = ( pthread_t * ) calloc( threads, sizeof( pthread_t ) );
+
+	if ( !workers || !handles ) { // Fall back to a single-threaded bubble sort rather than leave the array unsorted.
+		free( workers );
+		free( handles );
+
+		return bubble_sort_last_swap( arr, len );
+	}
+
+	pthread_mutex_init( &shared.start_lock, NULL );
+	pthread_cond_init( &shared.start_changed, NULL );
+	pthread_barrier_init( &shared.barrier, NULL, threads );
+
+	for ( uint32_t i = 0; i < SWAP_COUNT_SLOTS; i++ ) {
+		atomic_init( &shared.swaps[ i ], 0 );
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		workers[ t ].shared = &shared;
+		workers[ t ].id = t;
+		workers[ t ].stats = sorting_statistics_create( 0 );
+	}
+
+	uint32_t started = 1; // Thread 0 is the calling thread.
+
+	while ( started < threads && pthread_create( &handles[ started ], NULL, odd_even_worker, &workers[ started ] ) == 0 ) {
+		started++;
+	}
+
+	pthread_mutex_lock( &shared.start_lock );
+	shared.start_state = started == threads ? START_GO : START_ABORT;
+	pthread_cond_broadcast( &shared.start_changed );
+	pthread_mutex_unlock( &shared.start_lock );
+
+	if ( started == threads ) {
+		odd_even_worker( &workers[ 0 ] );
+	}
+
+	for ( uint32_t t = 1; t < started; t++ ) {
+		pthread_join( handles[ t ], NULL );
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		stats.compares += workers[ t ].stats.compares;
+		stats.moves += workers[ t ].stats.moves;
+	}
+
+	pthread_barrier_destroy( &shared.barrier );
+	pthread_cond_destroy( &shared.start_changed );
+	pthread_mutex_destroy( &shared.start_lock );
+	free( workers );
+	free( handles );
+
+	if ( started < threads ) { // Not every thread could be started, so sort on this thread alone.
+		uint32_t requested_threads = thread_count;
+		thread_count = 1;
+		stats = odd_even_sort( arr, len );
+		thread_count = requested_threads;
+	}
+
+	return stats;
+}
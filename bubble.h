@@ -7,4 +7,12 @@
 
 SortingStatistics bubble_sort( uint32_t *arr, uint32_t len );
 
+SortingStatistics bubble_sort_last_swap( uint32_t *arr, uint32_t len );
+
+SortingStatistics cocktail_sort( uint32_t *arr, uint32_t len );
+
+void bubble_set_thread_count( uint32_t threads );
+
+SortingStatistics odd_even_sort( uint32_t *arr, uint32_t len );
+
 #endif
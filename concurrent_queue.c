@@ -0,0 +1,199 @@
+#include "concurrent_queue.h"
+
+#include "huge_alloc.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CACHE_LINE_SIZE 64 // The size of a cache line in bytes.
+
+// Description:
+// A slot of a ConcurrentQueue.
+//
+// Members:
+// _Atomic uint64_t sequence - The position the slot is next ready for: pos when it can be written for position pos,
+//                             pos + 1 when it holds the item for position pos.
+// int64_t item - The item in the slot.
+typedef struct {
+	_Atomic uint64_t sequence;
+	int64_t item;
+} Slot;
+
+// Description:
+// A struct for the lock-free multi-producer multi-consumer ConcurrentQueue ADT (a bounded ring buffer with a
+// sequence number in each slot). head and tail are only ever incremented and are on their own cache lines,
+// so producers and consumers do not share a written cache line unless they use the same slot.
+//
+// Members:
+// _Atomic uint64_t head - The position of the next item to dequeue.
+// _Atomic uint64_t tail - The position of the next item to enqueue.
+// uint64_t mask - Capacity of the queue minus 1 (the capacity is a power of two).
+// Slot *slots - Holds the items.
+struct ConcurrentQueue {
+	_Alignas( CACHE_LINE_SIZE ) _Atomic uint64_t head;
+	_Alignas( CACHE_LINE_SIZE ) _Atomic uint64_t tail;
+	_Alignas( CACHE_LINE_SIZE ) uint64_t mask;
+	Slot *slots;
+};
+
+// Description:
+// Initializes a concurrent queue with at least a specified capacity. The capacity is rounded up to a power of two.
+//
+// Parameters:
+// size_t capacity - The min capacity of the queue.
+//
+// Returns:
+// ConcurrentQueue * - A pointer to the newly initialized queue.
+ConcurrentQueue *concurrent_queue_create( size_t capacity ) {
+	ConcurrentQueue *q = ( ConcurrentQueue * ) aligned_alloc( CACHE_LINE_SIZE, sizeof( ConcurrentQueue ) );
+
+	if ( q ) { // Make sure the memory allocated successfully to the struct.
+		uint64_t slot_count = 1;
+
+		while ( slot_count < capacity ) {
+			slot_count <<= 1;
+		}
+
+		atomic_init( &q->head, 0 );
+		atomic_init( &q->tail, 0 );
+		q->mask = slot_count - 1;
+		q->slots = slot_count <= SIZE_MAX / sizeof( Slot ) ? ( Slot * ) huge_alloc( slot_count * sizeof( Slot ) ) : NULL;
+
+		if ( !q->slots ) { // q->slots could not be allocated memory.
+			free( q );
+			q = NULL;
+		} else {
+			for ( uint64_t i = 0; i < slot_count; i++ ) {
+				atomic_init( &q->slots[ i ].sequence, i );
+			}
+		}
+	}
+
+	return q;
+}
+
+// Description:
+// Frees the memory given to a concurrent queue. No other thread may be using the queue.
+//
+// Parameters:
+// ConcurrentQueue **q - A pointer to a pointer to the queue to free the memory of.
+//
+// Returns:
+// Nothing.
+void concurrent_queue_delete( ConcurrentQueue **q ) {
+	if ( *q && ( *q )->slots ) { // Make sure the queue wasn't already deleted.
+		huge_free( ( *q )->slots, ( ( *q )->mask + 1 ) * sizeof( Slot ) );
+		free( *q );
+		*q = NULL;
+	}
+}
+
+// Description:
+// Checks if a concurrent queue is empty. Only a snapshot if other threads are using the queue.
+//
+// Parameters:
+// ConcurrentQueue *q - The queue to check.
+//
+// Returns:
+// bool - Whether the queue is empty.
+bool concurrent_queue_empty( ConcurrentQueue *q ) {
+	return concurrent_queue_size( q ) == 0;
+}
+
+// Description:
+// Checks if a concurrent queue is full. Only a snapshot if other threads are using the queue.
+//
+// Parameters:
+// ConcurrentQueue *q - The queue to check.
+//
+// Returns:
+// bool - Whether the queue is full.
+bool concurrent_queue_full( ConcurrentQueue *q ) {
+	return concurrent_queue_size( q ) > q->mask;
+}
+
+// Description:
+// Checks the size of a concurrent queue. Only a snapshot if other threads are using the queue.
+//
+// Parameters:
+// ConcurrentQueue *q - The queue to check.
+//
+// Returns:
+// size_t - The size of the queue.
+size_t concurrent_queue_size( ConcurrentQueue *q ) {
+	uint64_t head = atomic_load_explicit( &q->head, memory_order_acquire );
+	uint64_t tail = atomic_load_explicit( &q->tail, memory_order_acquire );
+
+	return tail > head ? ( size_t ) ( tail - head ) : 0; // head can be read before a dequeue that passes tail.
+}
+
+// Description:
+// Enqueues an item to a concurrent queue. Safe to call from any number of threads at once.
+//
+// Parameters:
+// ConcurrentQueue *q - The queue to enqueue to.
+// int64_t x - The value to enqueue.
+//
+// Returns:
+// bool - Whether the operation was successful (false if the queue was full).
+bool concurrent_queue_add( ConcurrentQueue *q, int64_t x ) {
+	uint64_t pos = atomic_load_explicit( &q->tail, memory_order_relaxed );
+	Slot *slot;
+
+	while ( true ) {
+		slot = &q->slots[ pos & q->mask ];
+		int64_t diff = ( int64_t ) ( atomic_load_explicit( &slot->sequence, memory_order_acquire ) - pos );
+
+		if ( diff == 0 ) { // The slot is free for this position, so try to claim it.
+			if ( atomic_compare_exchange_weak_explicit( &q->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed ) ) {
+				break;
+			}
+		} else if ( diff < 0 ) { // The slot still holds the item from one lap ago.
+			return false;
+		} else { // Another producer claimed the position.
+			pos = atomic_load_explicit( &q->tail, memory_order_relaxed );
+		}
+	}
+
+	slot->item = x;
+	atomic_store_explicit( &slot->sequence, pos + 1, memory_order_release );
+
+	return true;
+}
+
+// Description:
+// Dequeues an item from a concurrent queue. Safe to call from any number of threads at once.
+//
+// Parameters:
+// ConcurrentQueue *q - The queue to dequeue from.
+// int64_t *x - A pointer to a int64_t to set the dequeued value to.
+//
+// Returns:
+// bool - Whether the operation was successful (false if the queue was empty).
+bool concurrent_queue_remove( ConcurrentQueue *q, int64_t *x ) {
+	uint64_t pos = atomic_load_explicit( &q->head, memory_order_relaxed );
+	Slot *slot;
+
+	while ( true ) {
+		slot = &q->slots[ pos & q->mask ];
+		int64_t diff = ( int64_t ) ( atomic_load_explicit( &slot->sequence, memory_order_acquire ) - ( pos + 1 ) );
+
+		if ( diff == 0 ) { // The slot holds the item for this position, so try to claim it.
+			if ( atomic_compare_exchange_weak_explicit( &q->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed ) ) {
+				break;
+			}
+		} else if ( diff < 0 ) { // The item for this position has not been enqueued yet.
+			return false;
+		} else { // Another consumer claimed the position.
+			pos = atomic_load_explicit( &q->head, memory_order_relaxed );
+		}
+	}
+
+	*x = slot->item;
+	atomic_store_explicit( &slot->sequence, pos + q->mask + 1, memory_order_release );
+
+	return true;
+}
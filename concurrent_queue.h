@@ -0,0 +1,24 @@
+#ifndef __CONCURRENT_QUEUE_H__
+#define __CONCURRENT_QUEUE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ConcurrentQueue ConcurrentQueue;
+
+ConcurrentQueue *concurrent_queue_create( size_t capacity );
+
+void concurrent_queue_delete( ConcurrentQueue **q );
+
+bool concurrent_queue_empty( ConcurrentQueue *q );
+
+bool concurrent_queue_full( ConcurrentQueue *q );
+
+size_t concurrent_queue_size( ConcurrentQueue *q );
+
+bool concurrent_queue_add( ConcurrentQueue *q, int64_t x );
+
+bool concurrent_queue_remove( ConcurrentQueue *q, int64_t *x );
+
+#endif
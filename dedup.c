@@ -0,0 +1,360 @@
+#include "dedup.h"
+
+#include "large_sort.h"
+#include "pivot.h"
+#include "shell.h"
+#include "sorting_statistics.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SMALL_SORT_CUTOFF        16 // Ranges of at most this many elements are insertion sorted, then emitted run by run.
+#define INITIAL_PENDING_CAPACITY 64 // The number of pending blocks sort_and_emit( ) makes room for at first.
+
+// Description:
+// Where a fused sort writes its output, in sorted order.
+//
+// Members:
+// uint32_t *keys - The array unique keys are written to, or NULL to write counts.
+// KeyCount *counts - The array (key, count) pairs are written to, or NULL to write unique keys.
+// uint32_t len - The number of keys or pairs written so far.
+typedef struct {
+	uint32_t *keys;
+	KeyCount *counts;
+	uint32_t len;
+} Output;
+
+// Description:
+// A block of keys equal to a pivot, waiting to be emitted after every smaller key, and the range of greater
+// keys to sort after it.
+//
+// Members:
+// uint32_t pivot - The key of the block.
+// uint32_t count - The number of keys in the block.
+// int64_t lo - Starting point of the range of greater keys.
+// int64_t hi - Ending point of the range of greater keys.
+typedef struct {
+	uint32_t pivot;
+	uint32_t count;
+	int64_t lo;
+	int64_t hi;
+} PendingBlock;
+
+// Description:
+// Where the size_t-length fused sorts write their output, in sorted order.
+//
+// Members:
+// uint32_t *keys - The array unique keys are written to, or NULL to write counts.
+// KeyCount *counts - The array (key, count) pairs are written to, or NULL to write unique keys.
+// size_t len - The number of keys or pairs written so far.
+// SortingStatistics *stats - The statistics the ranges add to.
+typedef struct {
+	uint32_t *keys;
+	KeyCount *counts;
+	size_t len;
+	SortingStatistics *stats;
+} LargeOutput;
+
+// Description:
+// Writes one key and how often it occurs to the output. Keys are emitted in increasing order and each
+// key only once, since equal keys always end up in the same range.
+//
+// Parameters:
+// Output *output - The output.
+// uint32_t key - The key.
+// uint32_t count - The number of times the key occurs.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void emit( Output *output, uint32_t key, uint32_t count, SortingStatistics *stats ) {
+	if ( output->keys ) {
+		output->keys[ output->len++ ] = key;
+	} else {
+		output->counts[ output->len++ ] = ( KeyCount ) { key, count };
+	}
+
+	stats->moves++;
+}
+
+// Description:
+// Emits each run of equal keys in a sorted range.
+//
+// Parameters:
+// uint32_t *arr - The array.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// Output *output - The output.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void emit_runs( uint32_t *arr, int64_t lo, int64_t hi, Output *output, SortingStatistics *stats ) {
+	// The output never gets ahead of lo, so unique keys can be written over the range being read.
+	for ( int64_t i = lo; i <= hi; ) {
+		int64_t run = i + 1;
+
+		while ( run <= hi && ++stats->compares && arr[ run ] == arr[ i ] ) {
+			run++;
+		}
+
+		emit( output, arr[ i ], ( uint32_t ) ( run - i ), stats );
+		i = run;
+	}
+}
+
+// Description:
+// Sorts a small range with insertion sort, then emits each run of equal keys in it.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// Output *output - The output.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void sort_small_range( uint32_t *arr, int64_t lo, int64_t hi, Output *output, SortingStatistics *stats ) {
+	for ( int64_t i = lo + 1; i <= hi; i++ ) {
+		int64_t j = i;
+		uint32_t temp = arr[ i ];
+
+		while ( j > lo && ++stats->compares && temp < arr[ j - 1 ] ) {
+			arr[ j ] = arr[ j - 1 ];
+			stats->moves++;
+			j -= 1;
+		}
+
+		arr[ j ] = temp;
+		stats->moves += 2;
+	}
+
+	emit_runs( arr, lo, hi, output, stats );
+}
+
+// Description:
+// Sorts a range with three-way quicksort and emits its keys in order. Each partition gathers every key
+// equal to the pivot into one block, which collapses to a single output key without being looked at again.
+// The smaller keys are always sorted next, so the block and the greater keys wait on a stack that grows as
+// needed instead of on the call stack. If the stack cannot grow, the range is sorted with shell sort on the
+// Pratt gap sequence, which needs no memory or recursion, and its runs are emitted afterwards.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// Output *output - The output.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void sort_and_emit( uint32_t *arr, int64_t lo, int64_t hi, Output *output, SortingStatistics *stats ) {
+	PendingBlock *pending = NULL;
+	size_t pending_len = 0;
+	size_t pending_capacity = 0;
+
+	while ( true ) {
+		while ( hi - lo + 1 > SMALL_SORT_CUTOFF ) {
+			if ( pending_len == pending_capacity ) {
+				size_t capacity = pending_capacity > 0 ? pending_capacity * 2 : INITIAL_PENDING_CAPACITY;
+				PendingBlock *grown = ( PendingBlock * ) realloc( pending, capacity * sizeof( PendingBlock ) );
+
+				if ( !grown ) {
+					break;
+				}
+
+				pending = grown;
+				pending_capacity = capacity;
+			}
+
+			uint32_t pivot = ninther( arr + lo, ( size_t ) ( hi - lo + 1 ) );
+			int64_t lt = lo; // arr[lo..lt) < pivot.
+			int64_t i = lo; // arr[lt..i) == pivot.
+			int64_t gt = hi; // arr(gt..hi] > pivot.
+			stats->compares += NINTHER_COMPARES;
+
+			while ( i <= gt ) {
+				uint32_t x = arr[ i ];
+
+				if ( ++stats->compares && x < pivot ) {
+					arr[ i++ ] = arr[ lt ];
+					arr[ lt++ ] = x;
+					stats->moves += 2;
+				} else if ( ++stats->compares && x > pivot ) {
+					arr[ i ] = arr[ gt ];
+					arr[ gt-- ] = x;
+					stats->moves += 2;
+				} else {
+					i++;
+				}
+			}
+
+			pending[ pending_len++ ] = ( PendingBlock ) { .pivot = pivot, .count = ( uint32_t ) ( gt - lt + 1 ), .lo = gt + 1, .hi = hi };
+			hi = lt - 1;
+		}
+
+		if ( hi - lo + 1 > SMALL_SORT_CUTOFF ) { // The stack could not grow.
+			SortingStatistics sorted = shell_sort_pratt( arr + lo, ( uint32_t ) ( hi - lo + 1 ) );
+			stats->moves += sorted.moves;
+			stats->compares += sorted.compares;
+			emit_runs( arr, lo, hi, output, stats );
+		} else if ( lo <= hi ) {
+			sort_small_range( arr, lo, hi, output, stats );
+		}
+
+		if ( pending_len == 0 ) {
+			break;
+		}
+
+		PendingBlock block = pending[ --pending_len ];
+		emit( output, block.pivot, block.count, stats );
+		lo = block.lo;
+		hi = block.hi;
+	}
+
+	free( pending );
+}
+
+// Description:
+// Sorts an array and removes duplicate keys in the same pass. The unique keys are written over the start
+// of the array in increasing order, which is never ahead of the part still being sorted.
+//
+// Parameters:
+// uint32_t *arr - The array to sort. Set to the unique keys, followed by leftover elements.
+// uint32_t len - The length of the array.
+// uint32_t *unique_len - Set to the number of unique keys.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics quicksort_unique( uint32_t *arr, uint32_t len, uint32_t *unique_len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	Output output = { .keys = arr, .counts = NULL, .len = 0 };
+	sort_and_emit( arr, 0, ( int64_t ) len - 1, &output, &stats );
+	*unique_len = output.len;
+
+	return stats;
+}
+
+// Description:
+// Sorts an array and counts how often each key occurs in the same pass.
+//
+// Parameters:
+// uint32_t *arr - The array to sort. Left sorted.
+// uint32_t len - The length of the array.
+// KeyCount *counts - Set to the (key, count) pairs in increasing order of key. Needs space for as many pairs
+// as there are unique keys, which is at most len.
+// uint32_t *counts_len - Set to the number of pairs.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics quicksort_counts( uint32_t *arr, uint32_t len, KeyCount *counts, uint32_t *counts_len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	Output output = { .keys = NULL, .counts = counts, .len = 0 };
+	sort_and_emit( arr, 0, ( int64_t ) len - 1, &output, &stats );
+	*counts_len = output.len;
+
+	return stats;
+}
+
+// Description:
+// Deduplicates or counts one range for the size_t-length fused sorts with the 32-bit fused sort, then
+// appends its output.
+//
+// Parameters:
+// uint32_t *arr - The range.
+// uint32_t len - The length of the range.
+// void *ctx - A pointer to the LargeOutput.
+//
+// Returns:
+// Nothing.
+static void emit_range( uint32_t *arr, uint32_t len, void *ctx ) {
+	LargeOutput *output = ( LargeOutput * ) ctx;
+	uint32_t range_len = 0;
+	SortingStatistics stats;
+
+	if ( output->keys ) {
+		stats = quicksort_unique( arr, len, &range_len );
+		memmove( output->keys + output->len, arr, range_len * sizeof( uint32_t ) ); // The output is never ahead of arr.
+	} else {
+		stats = quicksort_counts( arr, len, output->counts + output->len, &range_len );
+	}
+
+	output->len += range_len;
+	output->stats->moves += stats.moves + range_len;
+	output->stats->compares += stats.compares;
+}
+
+// Description:
+// Emits a block of equal keys for the size_t-length fused sorts. A block of more keys than a count can hold
+// is emitted as several pairs with the same key.
+//
+// Parameters:
+// uint32_t *arr - The block.
+// size_t len - The length of the block.
+// void *ctx - A pointer to the LargeOutput.
+//
+// Returns:
+// Nothing.
+static void emit_block( uint32_t *arr, size_t len, void *ctx ) {
+	LargeOutput *output = ( LargeOutput * ) ctx;
+
+	if ( output->keys ) {
+		output->keys[ output->len++ ] = arr[ 0 ];
+		output->stats->moves++;
+
+		return;
+	}
+
+	for ( size_t left = len; left > 0; ) {
+		uint32_t count = left > UINT32_MAX ? UINT32_MAX : ( uint32_t ) left;
+		output->counts[ output->len++ ] = ( KeyCount ) { arr[ 0 ], count };
+		output->stats->moves++;
+		left -= count;
+	}
+}
+
+// Description:
+// Sorts an array of any length and removes duplicate keys in the same pass, like quicksort_unique( ).
+// Arrays too long for 32-bit indices are split with large_sort_visit( ) first.
+//
+// Parameters:
+// uint32_t *arr - The array to sort. Set to the unique keys, followed by leftover elements.
+// size_t len - The length of the array.
+// size_t *unique_len - Set to the number of unique keys.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics quicksort_unique_large( uint32_t *arr, size_t len, size_t *unique_len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	LargeOutput output = { .keys = arr, .counts = NULL, .len = 0, .stats = &stats };
+	large_sort_visit( arr, len, emit_range, emit_block, &output, &stats );
+	*unique_len = output.len;
+
+	return stats;
+}
+
+// Description:
+// Sorts an array of any length and counts how often each key occurs in the same pass, like
+// quicksort_counts( ). Arrays too long for 32-bit indices are split with large_sort_visit( ) first.
+//
+// Parameters:
+// uint32_t *arr - The array to sort. Left sorted.
+// size_t len - The length of the array.
+// KeyCount *counts - Set to the (key, count) pairs in increasing order of key. Needs space for at most len pairs.
+// A key occurring more than UINT32_MAX times gets several pairs.
+// size_t *counts_len - Set to the number of pairs.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics quicksort_counts_large( uint32_t *arr, size_t len, KeyCount *counts, size_t *counts_len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	LargeOutput output = { .keys = NULL, .counts = counts, .len = 0, .stats = &stats };
+	large_sort_visit( arr, len, emit_range, emit_block, &output, &stats );
+	*counts_len = output.len;
+
+	return stats;
+}
@@ -0,0 +1,24 @@
+#ifndef __DEDUP_H__
+#define __DEDUP_H__
+
+#include "sorting_statistics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct KeyCount KeyCount;
+
+struct KeyCount {
+	uint32_t key; // A key.
+	uint32_t count; // The number of times the key occurs.
+};
+
+SortingStatistics quicksort_unique( uint32_t *arr, uint32_t len, uint32_t *unique_len );
+
+SortingStatistics quicksort_counts( uint32_t *arr, uint32_t len, KeyCount *counts, uint32_t *counts_len );
+
+SortingStatistics quicksort_unique_large( uint32_t *arr, size_t len, size_t *unique_len );
+
+SortingStatistics quicksort_counts_large( uint32_t *arr, size_t len, KeyCount *counts, size_t *counts_len );
+
+#endif
@@ -0,0 +1,254 @@
+#include "deque.h"
+
+#include "huge_alloc.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CACHE_LINE_SIZE  64 // The size of a cache line in bytes.
+#define MIN_DEQUE_BUFFER 16 // The smallest buffer a deque will use.
+
+// Description:
+// A circular buffer backing a Deque. Buffers are replaced with ones twice as large when they fill up.
+//
+// Members:
+// uint64_t mask - Capacity of the buffer minus 1 (the capacity is a power of two).
+// struct Buffer *retired - The buffer this one replaced, kept until the deque is deleted since thieves may still read it.
+// _Atomic int64_t items[] - Holds the items.
+typedef struct Buffer {
+	uint64_t mask;
+	struct Buffer *retired;
+	_Atomic int64_t items[];
+} Buffer;
+
+// Description:
+// A struct for the Deque ADT, a Chase-Lev work-stealing deque. The owning thread pushes and pops at the bottom
+// like a stack, while any other thread can steal from the top. The owner only contends with thieves when
+// one item is left.
+//
+// Members:
+// _Atomic int64_t top - Index of the oldest item (where items are stolen from).
+// _Atomic int64_t bottom - Index of the next empty slot (where the owner pushes and pops).
+// _Atomic( Buffer * ) buffer - Holds the items.
+struct Deque {
+	_Alignas( CACHE_LINE_SIZE ) _Atomic int64_t top;
+	_Alignas( CACHE_LINE_SIZE ) _Atomic int64_t bottom;
+	_Alignas( CACHE_LINE_SIZE ) _Atomic( Buffer * ) buffer;
+};
+
+// Description:
+// Gets the number of bytes a buffer with a specified capacity takes.
+//
+// Parameters:
+// uint64_t capacity - The capacity of the buffer.
+//
+// Returns:
+// size_t - The size of the buffer in bytes.
+static size_t buffer_bytes( uint64_t capacity ) {
+	return sizeof( Buffer ) + capacity * sizeof( _Atomic int64_t );
+}
+
+// Description:
+// Allocates a buffer with a specified capacity.
+//
+// Parameters:
+// uint64_t capacity - The capacity of the buffer (must be a power of two).
+//
+// Returns:
+// Buffer * - A pointer to the newly allocated buffer.
+static Buffer *buffer_create( uint64_t capacity ) {
+	Buffer *b = capacity <= ( SIZE_MAX - sizeof( Buffer ) ) / sizeof( _Atomic int64_t ) ? ( Buffer * ) huge_alloc( buffer_bytes( capacity ) ) : NULL;
+
+	if ( b ) { // Make sure the memory allocated successfully to the struct.
+		b->mask = capacity - 1;
+		b->retired = NULL;
+	}
+
+	return b;
+}
+
+// Description:
+// Initializes a deque with a specified starting capacity. The capacity is rounded up to a power of two
+// and grows as needed.
+//
+// Parameters:
+// size_t capacity - The starting capacity of the deque.
+//
+// Returns:
+// Deque * - A pointer to the newly initialized deque.
+Deque *deque_create( size_t capacity ) {
+	Deque *d = ( Deque * ) aligned_alloc( CACHE_LINE_SIZE, sizeof( Deque ) );
+
+	if ( d ) { // Make sure the memory allocated successfully to the struct.
+		uint64_t buffer_capacity = MIN_DEQUE_BUFFER;
+
+		while ( buffer_capacity < capacity ) {
+			buffer_capacity <<= 1;
+		}
+
+		Buffer *b = buffer_create( buffer_capacity );
+
+		if ( !b ) { // The buffer could not be allocated memory.
+			free( d );
+			d = NULL;
+		} else {
+			atomic_init( &d->top, 0 );
+			atomic_init( &d->bottom, 0 );
+			atomic_init( &d->buffer, b );
+		}
+	}
+
+	return d;
+}
+
+// Description:
+// Frees the memory given to a deque. No other thread may be using the deque.
+//
+// Parameters:
+// Deque **d - A pointer to a pointer to the deque to free the memory of.
+//
+// Returns:
+// Nothing.
+void deque_delete( Deque **d ) {
+	if ( *d ) { // Make sure the deque wasn't already deleted.
+		Buffer *b = atomic_load_explicit( &( *d )->buffer, memory_order_relaxed );
+
+		while ( b ) {
+			Buffer *retired = b->retired;
+			huge_free( b, buffer_bytes( b->mask + 1 ) );
+			b = retired;
+		}
+
+		free( *d );
+		*d = NULL;
+	}
+}
+
+// Description:
+// Checks if a deque is empty. Only a snapshot if other threads are using the deque.
+//
+// Parameters:
+// Deque *d - The deque to check.
+//
+// Returns:
+// bool - Whether the deque is empty.
+bool deque_empty( Deque *d ) {
+	return deque_size( d ) == 0;
+}
+
+// Description:
+// Checks the size of a deque. Only a snapshot if other threads are using the deque.
+//
+// Parameters:
+// Deque *d - The deque to check.
+//
+// Returns:
+// size_t - The size of the deque.
+size_t deque_size( Deque *d ) {
+	int64_t bottom = atomic_load_explicit( &d->bottom, memory_order_relaxed );
+	int64_t top = atomic_load_explicit( &d->top, memory_order_relaxed );
+
+	return bottom > top ? ( size_t ) ( bottom - top ) : 0;
+}
+
+// Description:
+// Pushes a value to the bottom of a deque, growing it if it is full. Only the owning thread may push.
+//
+// Parameters:
+// Deque *d - The deque to push to.
+// int64_t x - The value to push to the deque.
+//
+// Returns:
+// bool - Whether the operation was successful (false if the deque could not grow).
+bool deque_push( Deque *d, int64_t x ) {
+	int64_t bottom = atomic_load_explicit( &d->bottom, memory_order_relaxed );
+	int64_t top = atomic_load_explicit( &d->top, memory_order_acquire );
+	Buffer *b = atomic_load_explicit( &d->buffer, memory_order_relaxed );
+
+	if ( ( uint64_t ) ( bottom - top ) > b->mask ) { // Full, so copy the items into a buffer twice as large.
+		Buffer *grown = buffer_create( ( b->mask + 1 ) * 2 );
+
+		if ( !grown ) {
+			return false;
+		}
+
+		for ( int64_t i = top; i < bottom; i++ ) {
+			int64_t item = atomic_load_explicit( &b->items[ i & b->mask ], memory_order_relaxed );
+			atomic_store_explicit( &grown->items[ i & grown->mask ], item, memory_order_relaxed );
+		}
+
+		grown->retired = b;
+		atomic_store_explicit( &d->buffer, grown, memory_order_release );
+		b = grown;
+	}
+
+	atomic_store_explicit( &b->items[ bottom & b->mask ], x, memory_order_relaxed );
+	atomic_store_explicit( &d->bottom, bottom + 1, memory_order_release ); // Publishes the item, and the array writes before it, to thieves.
+
+	return true;
+}
+
+// Description:
+// Pops the most recently pushed value from the bottom of a deque. Only the owning thread may pop.
+//
+// Parameters:
+// Deque *d - The deque to pop from.
+// int64_t *x - A pointer to a int64_t to set the popped value to.
+//
+// Returns:
+// bool - Whether the operation was successful (false if the deque was empty or a thief took the last item).
+bool deque_pop( Deque *d, int64_t *x ) {
+	int64_t bottom = atomic_load_explicit( &d->bottom, memory_order_relaxed ) - 1;
+	Buffer *b = atomic_load_explicit( &d->buffer, memory_order_relaxed );
+	atomic_store_explicit( &d->bottom, bottom, memory_order_relaxed );
+	atomic_thread_fence( memory_order_seq_cst ); // Thieves must see the reserved slot before we read top.
+	int64_t top = atomic_load_explicit( &d->top, memory_order_relaxed );
+	bool popped = true;
+
+	if ( top <= bottom ) {
+		*x = atomic_load_explicit( &b->items[ bottom & b->mask ], memory_order_relaxed );
+
+		if ( top == bottom ) { // The last item, so race the thieves for it.
+			popped = atomic_compare_exchange_strong_explicit( &d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed );
+			atomic_store_explicit( &d->bottom, bottom + 1, memory_order_relaxed );
+		}
+	} else { // Empty.
+		popped = false;
+		atomic_store_explicit( &d->bottom, bottom + 1, memory_order_relaxed );
+	}
+
+	return popped;
+}
+
+// Description:
+// Steals the oldest value from the top of a deque. Safe to call from any thread.
+//
+// Parameters:
+// Deque *d - The deque to steal from.
+// int64_t *x - A pointer to a int64_t to set the stolen value to.
+//
+// Returns:
+// bool - Whether the operation was successful (false if the deque was empty or another thread took the item).
+bool deque_steal( Deque *d, int64_t *x ) {
+	int64_t top = atomic_load_explicit( &d->top, memory_order_acquire );
+	atomic_thread_fence( memory_order_seq_cst );
+	int64_t bottom = atomic_load_explicit( &d->bottom, memory_order_acquire );
+
+	if ( top >= bottom ) { // Empty.
+		return false;
+	}
+
+	Buffer *b = atomic_load_explicit( &d->buffer, memory_order_acquire );
+	int64_t item = atomic_load_explicit( &b->items[ top & b->mask ], memory_order_relaxed );
+
+	if ( !atomic_compare_exchange_strong_explicit( &d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed ) ) {
+		return false;
+	}
+
+	*x = item;
+
+	return true;
+}
@@ -0,0 +1,24 @@
+#ifndef __DEQUE_H__
+#define __DEQUE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct Deque Deque;
+
+Deque *deque_create( size_t capacity );
+
+void deque_delete( Deque **d );
+
+bool deque_empty( Deque *d );
+
+size_t deque_size( Deque *d );
+
+bool deque_push( Deque *d, int64_t x );
+
+bool deque_pop( Deque *d, int64_t *x );
+
+bool deque_steal( Deque *d, int64_t *x );
+
+#endif
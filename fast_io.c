@@ -0,0 +1,404 @@
+#include "fast_io.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MIN_WRITER_CAPACITY  16 // The smallest output buffer a writer will use (must hold one padded field).
+#define PADDED_FIELD_SPACING 3 // The number of spaces before each padded field.
+#define READ_CHUNK_SIZE      ( 1 << 20 ) // The number of bytes to read from an input file at a time.
+#define SWAR_ONES            0x0101010101010101ULL // A byte of 1 in each of the 8 lanes of a uint64_t.
+
+// Two ASCII digits for every value from 0 to 99, so two digits can be formatted with one lookup.
+static const char digit_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869"
+                                  "707172737475767778798081828384858687888990919293949596979899";
+
+static const uint32_t powers_of_ten[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+// Description:
+// A struct for a buffered writer that writes to a file descriptor.
+//
+// Members:
+// int fd - The file descriptor to write to.
+// uint32_t len - The number of bytes currently in the buffer.
+// uint32_t capacity - Capacity of the buffer.
+// char *buf - Holds the bytes that have not been written yet.
+struct FastWriter {
+	int fd;
+	uint32_t len;
+	uint32_t capacity;
+	char *buf;
+};
+
+// Description:
+// Counts the number of decimal digits in a number without looping over the digits.
+//
+// Parameters:
+// uint32_t x - The number to count the digits of.
+//
+// Returns:
+// uint32_t - The number of decimal digits in x (1 for 0).
+static uint32_t count_digits( uint32_t x ) {
+	uint32_t bits = 32 - __builtin_clz( x | 1 );
+	uint32_t guess = ( bits * 1233 ) >> 12; // bits * log10(2), which is off by at most one.
+
+	return guess + 1 - ( ( x | 1 ) < powers_of_ten[ guess ] );
+}
+
+// Description:
+// Writes all of a buffer to a file descriptor, retrying on partial writes.
+//
+// Parameters:
+// int fd - The file descriptor to write to.
+// const char *bytes - The bytes to write.
+// uint32_t len - The number of bytes to write.
+//
+// Returns:
+// bool - Whether the operation was successful.
+static bool write_all( int fd, const char *bytes, uint32_t len ) {
+	while ( len > 0 ) {
+		ssize_t written = write( fd, bytes, len );
+
+		if ( written < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+
+			return false;
+		}
+
+		bytes += written;
+		len -= ( uint32_t ) written;
+	}
+
+	return true;
+}
+
+// Description:
+// Makes sure a writer has room for a number of bytes, flushing it if needed.
+//
+// Parameters:
+// FastWriter *w - The writer to make room in.
+// uint32_t needed - The number of bytes that will be appended.
+//
+// Returns:
+// bool - Whether the operation was successful.
+static inline bool reserve( FastWriter *w, uint32_t needed ) {
+	if ( w->capacity - w->len >= needed ) {
+		return true;
+	}
+
+	return fast_writer_flush( w );
+}
+
+// Description:
+// Initializes a writer with a specified output buffer capacity.
+//
+// Parameters:
+// int fd - The file descriptor to write to.
+// uint32_t capacity - The size of the output buffer in bytes.
+//
+// Returns:
+// FastWriter * - A pointer to the newly initialized writer.
+FastWriter *fast_writer_create( int fd, uint32_t capacity ) {
+	FastWriter *w = ( FastWriter * ) malloc( sizeof( FastWriter ) );
+
+	if ( w ) { // Make sure the memory allocated successfully to the struct.
+		w->fd = fd;
+		w->len = 0;
+		w->capacity = capacity < MIN_WRITER_CAPACITY ? MIN_WRITER_CAPACITY : capacity;
+		w->buf = ( char * ) malloc( w->capacity );
+
+		if ( !w->buf ) { // w->buf could not be allocated memory.
+			free( w );
+			w = NULL;
+		}
+	}
+
+	return w;
+}
+
+// Description:
+// Flushes a writer and frees the memory given to it.
+//
+// Parameters:
+// FastWriter **w - A pointer to a pointer to the writer to free the memory of.
+//
+// Returns:
+// Nothing.
+void fast_writer_delete( FastWriter **w ) {
+	if ( *w && ( *w )->buf ) { // Make sure the writer wasn't already deleted.
+		fast_writer_flush( *w );
+		free( ( *w )->buf );
+		free( *w );
+		*w = NULL;
+	}
+}
+
+// Description:
+// Writes everything in a writer's buffer to its file descriptor with a single write().
+//
+// Parameters:
+// FastWriter *w - The writer to flush.
+//
+// Returns:
+// bool - Whether the operation was successful.
+bool fast_writer_flush( FastWriter *w ) {
+	bool ok = write_all( w->fd, w->buf, w->len );
+	w->len = 0;
+
+	return ok;
+}
+
+// Description:
+// Appends raw bytes to a writer.
+//
+// Parameters:
+// FastWriter *w - The writer to append to.
+// const char *bytes - The bytes to append.
+// uint32_t len - The number of bytes to append.
+//
+// Returns:
+// bool - Whether the operation was successful.
+bool fast_writer_bytes( FastWriter *w, const char *bytes, uint32_t len ) {
+	if ( !reserve( w, len ) ) {
+		return false;
+	}
+
+	if ( len > w->capacity ) { // Too big to ever fit in the buffer, so write it directly.
+		return write_all( w->fd, bytes, len );
+	}
+
+	memcpy( w->buf + w->len, bytes, len );
+	w->len += len;
+
+	return true;
+}
+
+// Description:
+// Appends a number in decimal to a writer.
+//
+// Parameters:
+// FastWriter *w - The writer to append to.
+// uint32_t x - The number to append.
+//
+// Returns:
+// bool - Whether the operation was successful.
+bool fast_writer_u32( FastWriter *w, uint32_t x ) {
+	if ( !reserve( w, FAST_IO_U32_FIELD_WIDTH ) ) {
+		return false;
+	}
+
+	w->len += fast_io_format_u32( w->buf + w->len, x );
+
+	return true;
+}
+
+// Description:
+// Appends a number in decimal to a writer, right-aligned in a fixed width field after three spaces.
+// This produces the same output as printf( "   %10" PRIu32, x ).
+//
+// Parameters:
+// FastWriter *w - The writer to append to.
+// uint32_t x - The number to append.
+//
+// Returns:
+// bool - Whether the operation was successful.
+bool fast_writer_u32_padded( FastWriter *w, uint32_t x ) {
+	if ( !reserve( w, PADDED_FIELD_SPACING + FAST_IO_U32_FIELD_WIDTH ) ) {
+		return false;
+	}
+
+	char *field = w->buf + w->len;
+	memset( field, ' ', PADDED_FIELD_SPACING + FAST_IO_U32_FIELD_WIDTH );
+	fast_io_format_u32( field + PADDED_FIELD_SPACING + FAST_IO_U32_FIELD_WIDTH - count_digits( x ), x );
+	w->len += PADDED_FIELD_SPACING + FAST_IO_U32_FIELD_WIDTH;
+
+	return true;
+}
+
+// Description:
+// Formats a number in decimal, two digits at a time using a lookup table.
+// The output is not null-terminated.
+//
+// Parameters:
+// char *buf - The buffer to format into (must have room for FAST_IO_U32_FIELD_WIDTH characters).
+// uint32_t x - The number to format.
+//
+// Returns:
+// uint32_t - The number of characters written.
+uint32_t fast_io_format_u32( char *buf, uint32_t x ) {
+	uint32_t digits = count_digits( x );
+	uint32_t pos = digits;
+
+	while ( x >= 100 ) {
+		pos -= 2;
+		memcpy( buf + pos, digit_pairs + ( x % 100 ) * 2, 2 );
+		x /= 100;
+	}
+
+	if ( x >= 10 ) {
+		memcpy( buf, digit_pairs + x * 2, 2 );
+	} else {
+		buf[ 0 ] = ( char ) ( '0' + x );
+	}
+
+	return digits;
+}
+
+// Description:
+// Parses a decimal number, converting eight digits at a time with SWAR (SIMD within a register) arithmetic
+// when there are enough bytes left in the input.
+//
+// Parameters:
+// const char **str - A pointer to the start of the number; advanced past the digits that were parsed.
+// const char *end - The end of the input.
+// uint32_t *x - A pointer to a uint32_t to set the parsed value to.
+//
+// Returns:
+// bool - Whether a number was parsed (false if there were no digits or the number does not fit in a uint32_t).
+bool fast_io_parse_u32( const char **str, const char *end, uint32_t *x ) {
+	const char *p = *str;
+	uint64_t value = 0;
+
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	if ( end - p >= 8 ) {
+		uint64_t chunk;
+		memcpy( &chunk, p, sizeof( chunk ) );
+		uint64_t lanes = chunk - 0x30 * SWAR_ONES;
+
+		// The high bit of a lane is set if its byte is not '0' to '9'.
+		uint64_t non_digits = ( lanes | ( chunk + 0x46 * SWAR_ONES ) ) & ( 0x80 * SWAR_ONES );
+		uint32_t n = non_digits ? ( uint32_t ) __builtin_ctzll( non_digits ) / 8 : 8;
+
+		if ( n > 0 ) {
+			// Move the digits to the top lanes so the empty lanes act as leading zeros.
+			lanes <<= 8 * ( 8 - n );
+			lanes = ( lanes * 10 + ( lanes >> 8 ) ) & 0x00FF00FF00FF00FFULL;
+			lanes = ( lanes * 100 + ( lanes >> 16 ) ) & 0x0000FFFF0000FFFFULL;
+			value = ( lanes * 10000 + ( lanes >> 32 ) ) & 0xFFFFFFFFULL;
+			p += n;
+		}
+	}
+#endif
+
+	const char *digits_start = *str;
+
+	while ( p < end && *p >= '0' && *p <= '9' ) {
+		value = value * 10 + ( uint64_t ) ( *p - '0' );
+		p++;
+
+		if ( value > UINT32_MAX ) {
+			return false;
+		}
+	}
+
+	if ( p == digits_start ) { // No digits.
+		return false;
+	}
+
+	*x = ( uint32_t ) value;
+	*str = p;
+
+	return true;
+}
+
+// Description:
+// Reads whitespace-separated decimal keys from a file.
+//
+// Parameters:
+// const char *path - The path to the file to read.
+// uint32_t *len - A pointer to a uint32_t to set the number of keys read to.
+//
+// Returns:
+// uint32_t * - A pointer to the newly allocated array of keys, or NULL if the file could not be read or parsed.
+uint32_t *fast_io_read_keys( const char *path, uint32_t *len ) {
+	FILE *file = fopen( path, "rb" );
+	*len = 0;
+
+	if ( !file ) {
+		return NULL;
+	}
+
+	// Read the whole file in large chunks.
+	size_t text_len = 0;
+	size_t text_capacity = READ_CHUNK_SIZE;
+	char *text = ( char * ) malloc( text_capacity );
+	size_t bytes_read = 0;
+
+	while ( text && ( bytes_read = fread( text + text_len, 1, text_capacity - text_len, file ) ) > 0 ) {
+		text_len += bytes_read;
+
+		if ( text_len == text_capacity ) {
+			text_capacity *= 2;
+			char *grown = ( char * ) realloc( text, text_capacity );
+
+			if ( !grown ) {
+				free( text );
+			}
+
+			text = grown;
+		}
+	}
+
+	bool read_error = ferror( file );
+	fclose( file );
+
+	if ( !text || read_error ) {
+		free( text );
+
+		return NULL;
+	}
+
+	// Parse the keys.
+	uint32_t count = 0;
+	uint32_t capacity = READ_CHUNK_SIZE / sizeof( uint32_t );
+	uint32_t *keys = ( uint32_t * ) malloc( capacity * sizeof( uint32_t ) );
+	const char *p = text;
+	const char *end = text + text_len;
+
+	while ( keys ) {
+		while ( p < end && ( *p == ' ' || *p == '\n' || *p == '\t' || *p == '\r' ) ) {
+			p++;
+		}
+
+		if ( p == end ) {
+			break;
+		}
+
+		if ( count == UINT32_MAX || !fast_io_parse_u32( &p, end, &keys[ count ] ) ) { // Not a valid key.
+			free( keys );
+			keys = NULL;
+
+			break;
+		}
+
+		count++;
+
+		if ( count == capacity ) {
+			capacity = capacity > UINT32_MAX / 2 ? UINT32_MAX : capacity * 2;
+			uint32_t *grown = ( uint32_t * ) realloc( keys, ( size_t ) capacity * sizeof( uint32_t ) );
+
+			if ( !grown ) {
+				free( keys );
+			}
+
+			keys = grown;
+		}
+	}
+
+	free( text );
+
+	if ( keys && count == 0 ) { // An empty file has nothing to sort.
+		free( keys );
+		keys = NULL;
+	}
+
+	*len = keys ? count : 0;
+
+	return keys;
+}
@@ -0,0 +1,29 @@
+#ifndef __FAST_IO_H__
+#define __FAST_IO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FAST_IO_U32_FIELD_WIDTH 10 // The width of a right-aligned uint32_t field (the max number of digits in a uint32_t).
+
+typedef struct FastWriter FastWriter;
+
+FastWriter *fast_writer_create( int fd, uint32_t capacity );
+
+void fast_writer_delete( FastWriter **w );
+
+bool fast_writer_flush( FastWriter *w );
+
+bool fast_writer_bytes( FastWriter *w, const char *bytes, uint32_t len );
+
+bool fast_writer_u32( FastWriter *w, uint32_t x );
+
+bool fast_writer_u32_padded( FastWriter *w, uint32_t x );
+
+uint32_t fast_io_format_u32( char *buf, uint32_t x );
+
+bool fast_io_parse_u32( const char **str, const char *end, uint32_t *x );
+
+uint32_t *fast_io_read_keys( const char *path, uint32_t *len );
+
+#endif
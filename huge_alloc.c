@@ -0,0 +1,87 @@
+#include "huge_alloc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#define HUGE_PAGE_SIZE ( ( size_t ) 2 << 20 ) // The size of a transparent huge page on x86-64 and most ARM64 kernels.
+
+// Description:
+// Rounds a size up to a whole number of huge pages.
+//
+// Parameters:
+// size_t bytes - The size.
+//
+// Returns:
+// size_t - The rounded size.
+static size_t huge_page_round( size_t bytes ) {
+	return ( bytes + HUGE_PAGE_SIZE - 1 ) & ~( HUGE_PAGE_SIZE - 1 );
+}
+
+// Description:
+// Allocates zeroed memory. Allocations of at least a huge page are mapped on their own, aligned to a huge
+// page and marked for transparent huge pages, so large arrays take far fewer TLB entries. Smaller ones come
+// from calloc( ).
+//
+// Parameters:
+// size_t bytes - The number of bytes to allocate.
+//
+// Returns:
+// void * - A pointer to the memory, or NULL if it could not be allocated. Free it with huge_free( ).
+void *huge_alloc( size_t bytes ) {
+	if ( bytes < HUGE_PAGE_SIZE ) {
+		return calloc( bytes > 0 ? bytes : 1, 1 );
+	}
+
+	size_t length = huge_page_round( bytes );
+
+	if ( length < bytes || length + HUGE_PAGE_SIZE < length ) { // The size overflowed.
+		return NULL;
+	}
+
+	// Map a huge page extra so an aligned start can be cut out of it, then unmap the ends.
+	uint8_t *map = ( uint8_t * ) mmap( NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+	if ( map == MAP_FAILED ) {
+		return NULL;
+	}
+
+	uint8_t *start = ( uint8_t * ) huge_page_round( ( uintptr_t ) map );
+	uint8_t *end = start + length;
+
+	if ( start > map ) {
+		munmap( map, start - map );
+	}
+
+	if ( map + length + HUGE_PAGE_SIZE > end ) {
+		munmap( end, map + length + HUGE_PAGE_SIZE - end );
+	}
+
+#ifdef MADV_HUGEPAGE
+	madvise( start, length, MADV_HUGEPAGE ); // Only a hint: it fails harmlessly where huge pages are off.
+#endif
+
+	return start;
+}
+
+// Description:
+// Frees memory from huge_alloc( ).
+//
+// Parameters:
+// void *ptr - The memory, or NULL.
+// size_t bytes - The number of bytes it was allocated with.
+//
+// Returns:
+// Nothing.
+void huge_free( void *ptr, size_t bytes ) {
+	if ( !ptr ) {
+		return;
+	}
+
+	if ( bytes < HUGE_PAGE_SIZE ) {
+		free( ptr );
+	} else {
+		munmap( ptr, huge_page_round( bytes ) );
+	}
+}
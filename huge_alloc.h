@@ -0,0 +1,10 @@
+#ifndef __HUGE_ALLOC_H__
+#define __HUGE_ALLOC_H__
+
+#include <stddef.h>
+
+void *huge_alloc( size_t bytes );
+
+void huge_free( void *ptr, size_t bytes );
+
+#endif
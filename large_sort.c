@@ -0,0 +1,118 @@
+#include "large_sort.h"
+
+#include "pivot.h"
+#include "sorting_statistics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LARGE_RANGE_MAX
+#define LARGE_RANGE_MAX ( ( size_t ) INT32_MAX ) // The largest range handed to a 32-bit sort, leaving its index math headroom.
+#endif
+
+// Description:
+// The state of sort_large( ).
+//
+// Members:
+// SortingStatistics ( *sort )( uint32_t *, uint32_t ) - The 32-bit sort each range is handed to.
+// SortingStatistics *stats - The statistics all the ranges add to.
+typedef struct {
+	SortingStatistics ( *sort )( uint32_t *, uint32_t );
+	SortingStatistics *stats;
+} LargeSort;
+
+// Description:
+// Splits arrays of any length into ranges that 32-bit code can handle. Ranges are three-way partitioned
+// around their ninther with 64-bit indices until they have at most LARGE_RANGE_MAX elements, so every key
+// equal to a pivot ends up in one block and each range holds keys no other range or block holds. Ranges and
+// blocks are visited in increasing order of their keys, and an array that already fits is visited whole
+// without being looked at.
+//
+// Parameters:
+// uint32_t *arr - The array.
+// size_t len - The length of the array.
+// void ( *range )( uint32_t *, uint32_t, void * ) - Called with each range, its length and ctx.
+// void ( *equal )( uint32_t *, size_t, void * ) - Called with each block of equal keys, its length and ctx, or NULL.
+// void *ctx - Passed to range and equal.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the partitioning.
+//
+// Returns:
+// Nothing.
+void large_sort_visit( uint32_t *arr, size_t len, void ( *range )( uint32_t *, uint32_t, void * ), void ( *equal )( uint32_t *, size_t, void * ), void *ctx, SortingStatistics *stats ) {
+	while ( len > LARGE_RANGE_MAX ) {
+		uint32_t pivot = ninther( arr, len );
+		size_t lt = 0; // arr[0..lt) < pivot.
+		size_t i = 0; // arr[lt..i) == pivot.
+		size_t gt = len; // arr[gt..len) > pivot.
+		stats->compares += NINTHER_COMPARES;
+
+		while ( i < gt ) {
+			uint32_t x = arr[ i ];
+
+			if ( ++stats->compares && x < pivot ) {
+				arr[ i++ ] = arr[ lt ];
+				arr[ lt++ ] = x;
+				stats->moves += 2;
+			} else if ( ++stats->compares && x > pivot ) {
+				arr[ i ] = arr[ --gt ];
+				arr[ gt ] = x;
+				stats->moves += 2;
+			} else {
+				i++;
+			}
+		}
+
+		large_sort_visit( arr, lt, range, equal, ctx, stats );
+
+		if ( equal ) {
+			equal( arr + lt, gt - lt, ctx );
+		}
+
+		arr += gt; // Only ranges longer than LARGE_RANGE_MAX recurse, so the recursion stays shallow.
+		len -= gt;
+	}
+
+	if ( len > 0 ) {
+		range( arr, ( uint32_t ) len, ctx );
+	}
+}
+
+// Description:
+// Sorts one range for sort_large( ).
+//
+// Parameters:
+// uint32_t *arr - The range.
+// uint32_t len - The length of the range.
+// void *ctx - A pointer to the LargeSort.
+//
+// Returns:
+// Nothing.
+static void sort_range( uint32_t *arr, uint32_t len, void *ctx ) {
+	LargeSort *large = ( LargeSort * ) ctx;
+	SortingStatistics stats = large->sort( arr, len );
+	large->stats->moves += stats.moves;
+	large->stats->compares += stats.compares;
+
+	if ( stats.max_ds_size > large->stats->max_ds_size ) {
+		large->stats->max_ds_size = stats.max_ds_size;
+	}
+}
+
+// Description:
+// Sorts an array of any length with a sort that takes 32-bit lengths. Arrays that fit in a 32-bit sort are
+// handed to it directly, so they keep its speed; larger ones are split with large_sort_visit( ) first.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// size_t len - The length of the array to sort.
+// SortingStatistics ( *sort )( uint32_t *, uint32_t ) - The sort, such as quicksort_recursive.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort, including the splitting.
+SortingStatistics sort_large( uint32_t *arr, size_t len, SortingStatistics ( *sort )( uint32_t *, uint32_t ) ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	LargeSort large = { .sort = sort, .stats = &stats };
+	large_sort_visit( arr, len, sort_range, NULL, &large, &stats );
+
+	return stats;
+}
@@ -0,0 +1,13 @@
+#ifndef __LARGE_SORT_H__
+#define __LARGE_SORT_H__
+
+#include "sorting_statistics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+void large_sort_visit( uint32_t *arr, size_t len, void ( *range )( uint32_t *, uint32_t, void * ), void ( *equal )( uint32_t *, size_t, void * ), void *ctx, SortingStatistics *stats );
+
+SortingStatistics sort_large( uint32_t *arr, size_t len, SortingStatistics ( *sort )( uint32_t *, uint32_t ) );
+
+#endif
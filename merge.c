@@ -0,0 +1,326 @@
+#include "merge.h"
+
+#include "huge_alloc.h"
+#include "large_sort.h"
+#include "quick.h"
+#include "sorting_statistics.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARALLEL_MERGE_CUTOFF ( 1 << 16 ) // Merges that write fewer elements than this stay on the calling thread.
+
+static uint32_t thread_count = 1;
+
+// Description:
+// One slice of the output of a merge, merged by one thread.
+//
+// Members:
+// uint32_t *arr - The array being merged into. The base is read from it in place.
+// const uint32_t *batch - The sorted batch.
+// size_t base_lo - The first base element of the slice.
+// size_t base_hi - One past the last base element of the slice.
+// size_t batch_lo - The first batch element of the slice.
+// size_t batch_hi - One past the last batch element of the slice.
+// uint32_t *saved - A copy of the base elements the slice before this one overwrites.
+// size_t saved_len - The number of saved base elements (the first ones of the slice).
+// SortingStatistics stats - The statistics of the slice.
+typedef struct {
+	uint32_t *arr;
+	const uint32_t *batch;
+	size_t base_lo;
+	size_t base_hi;
+	size_t batch_lo;
+	size_t batch_hi;
+	uint32_t *saved;
+	size_t saved_len;
+	SortingStatistics stats;
+} MergeTask;
+
+// Description:
+// Finds how many elements at the start of a sorted range are no greater than a key. Gallops from
+// the end of the range, since the merge takes elements from the back and the answer is usually close.
+//
+// Parameters:
+// const uint32_t *a - The sorted range.
+// size_t len - The length of the range.
+// uint32_t key - The key to look for.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the merge.
+//
+// Returns:
+// size_t - The number of elements no greater than key.
+static size_t gallop_upper_bound( const uint32_t *a, size_t len, uint32_t key, SortingStatistics *stats ) {
+	size_t lo = 0;
+	size_t hi = len; // a[hi..len) are known to be greater than key.
+	size_t step = 1;
+
+	// Double the step back from the end until an element no greater than key is found.
+	while ( step <= hi && ++stats->compares && a[ hi - step ] > key ) {
+		hi -= step;
+		step *= 2;
+	}
+
+	lo = step <= hi ? hi - step + 1 : 0;
+
+	while ( lo < hi ) {
+		size_t mid = lo + ( hi - lo ) / 2;
+
+		if ( ++stats->compares && a[ mid ] > key ) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	return lo;
+}
+
+// Description:
+// Merges two sorted ranges backward into the elements just before out_end, stopping once the first
+// range is used up. The first range may lie in the output as long as it ends at or before out_end.
+// Runs of the first range that go before the next element of the second are moved as blocks.
+//
+// Parameters:
+// uint32_t *out_end - One past the last element to write.
+// const uint32_t *a - The first sorted range. Its elements go before equal elements of b.
+// size_t a_len - The length of the first range.
+// const uint32_t *b - The second sorted range.
+// size_t b_len - The length of the second range.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the merge.
+//
+// Returns:
+// size_t - The number of elements of b that were not merged (they all go before every element of a).
+static size_t merge_backward( uint32_t *out_end, const uint32_t *a, size_t a_len, const uint32_t *b, size_t b_len, SortingStatistics *stats ) {
+	uint32_t *out = out_end;
+
+	while ( a_len > 0 && b_len > 0 ) {
+		if ( ++stats->compares && a[ a_len - 1 ] > b[ b_len - 1 ] ) {
+			size_t keep = gallop_upper_bound( a, a_len - 1, b[ b_len - 1 ], stats );
+			size_t run = a_len - keep;
+			out -= run;
+			memmove( out, a + keep, run * sizeof( uint32_t ) );
+			stats->moves += run;
+			a_len = keep;
+		} else {
+			*--out = b[ --b_len ];
+			stats->moves++;
+		}
+	}
+
+	if ( a_len > 0 ) {
+		out -= a_len;
+		memmove( out, a, a_len * sizeof( uint32_t ) );
+		stats->moves += a_len;
+	}
+
+	return b_len;
+}
+
+// Description:
+// Merges one slice: first the base elements still in place, then the saved ones, then whatever is left
+// of the batch.
+//
+// Parameters:
+// void *arg - A pointer to the MergeTask.
+//
+// Returns:
+// void * - NULL.
+static void *merge_slice( void *arg ) {
+	MergeTask *task = ( MergeTask * ) arg;
+	uint32_t *out_end = task->arr + task->base_hi + task->batch_hi;
+	size_t in_place = task->base_lo + task->saved_len;
+	size_t batch_len = task->batch_hi - task->batch_lo;
+	const uint32_t *batch = task->batch + task->batch_lo;
+
+	size_t left = merge_backward( out_end, task->arr + in_place, task->base_hi - in_place, batch, batch_len, &task->stats );
+	out_end -= ( task->base_hi - in_place ) + ( batch_len - left );
+	size_t rest = merge_backward( out_end, task->saved, task->saved_len, batch, left, &task->stats );
+	out_end -= task->saved_len + ( left - rest );
+	memcpy( out_end - rest, batch, rest * sizeof( uint32_t ) );
+	task->stats.moves += rest;
+
+	return NULL;
+}
+
+// Description:
+// Splits a merge at an output rank: finds how many of the first k merged elements come from the batch,
+// with base elements going before equal batch elements.
+//
+// Parameters:
+// const uint32_t *base - The sorted base.
+// size_t base_len - The length of the base.
+// const uint32_t *batch - The sorted batch.
+// size_t batch_len - The length of the batch.
+// size_t k - The output rank.
+//
+// Returns:
+// size_t - The number of batch elements among the first k merged elements.
+static size_t co_rank( const uint32_t *base, size_t base_len, const uint32_t *batch, size_t batch_len, size_t k ) {
+	size_t lo = k > base_len ? k - base_len : 0;
+	size_t hi = k < batch_len ? k : batch_len;
+
+	while ( lo < hi ) {
+		size_t j = lo + ( hi - lo ) / 2; // Try taking j batch elements and k - j base elements.
+		size_t i = k - j;
+
+		if ( i > 0 && j < batch_len && base[ i - 1 ] > batch[ j ] ) {
+			lo = j + 1; // Base element i - 1 belongs after batch element j, so more batch elements are needed.
+		} else {
+			hi = j;
+		}
+	}
+
+	return lo;
+}
+
+// Description:
+// Sets the number of threads merge_batch_large( ) uses for large merges.
+//
+// Parameters:
+// uint32_t threads - The number of threads (at least 1).
+//
+// Returns:
+// Nothing.
+void merge_set_thread_count( uint32_t threads ) {
+	thread_count = threads > 0 ? threads : 1;
+}
+
+// Description:
+// Adds a batch of new elements to a sorted array without sorting it from scratch. Only the batch is sorted,
+// then it is merged into the sorted part from the back, so the base before the first new element is never
+// touched and runs of the base between new elements are moved as blocks. Large merges are split into slices
+// by output rank and merged in parallel. Falls back to quicksorting the whole array if memory runs out.
+//
+// Parameters:
+// uint32_t *arr - The array. Elements [0, sorted_len) are sorted and [sorted_len, len) are the new batch.
+// size_t sorted_len - The length of the sorted base.
+// size_t len - The length of the whole array.
+//
+// Returns:
+// SortingStatistics - The statistics for sorting the batch and merging it.
+SortingStatistics merge_batch_large( uint32_t *arr, size_t sorted_len, size_t len ) {
+	size_t batch_len = len - sorted_len;
+	SortingStatistics stats = batch_len > 0 ? sort_large( arr + sorted_len, batch_len, quicksort_recursive ) : sorting_statistics_create( 0 );
+	stats.elements = len;
+
+	if ( batch_len == 0 || sorted_len == 0 || arr[ sorted_len - 1 ] <= arr[ sorted_len ] ) {
+		return stats; // The batch already goes after the whole base.
+	}
+
+	uint32_t *batch = ( uint32_t * ) huge_alloc( batch_len * sizeof( uint32_t ) );
+
+	if ( !batch ) {
+		SortingStatistics fallback = sort_large( arr, len, quicksort_recursive );
+		fallback.moves += stats.moves;
+		fallback.compares += stats.compares;
+
+		return fallback;
+	}
+
+	memcpy( batch, arr + sorted_len, batch_len * sizeof( uint32_t ) );
+	stats.moves += batch_len;
+
+	// Nothing before the first base element greater than the smallest new element moves.
+	size_t start = gallop_upper_bound( arr, sorted_len, batch[ 0 ], &stats );
+	size_t written = len - start;
+	uint32_t threads = written < PARALLEL_MERGE_CUTOFF ? 1 : thread_count;
+	MergeTask *tasks = ( MergeTask * ) calloc( threads, sizeof( MergeTask ) );
+	pthread_t *handles = ( pthread_t * ) calloc( threads, sizeof( pthread_t ) );
+	bool *started = ( bool * ) calloc( threads, sizeof( bool ) );
+	uint32_t *saved = NULL;
+	size_t saved_total = 0;
+
+	if ( tasks && handles && started ) {
+		for ( uint32_t t = 0; t < threads; t++ ) {
+			size_t k_lo = written * t / threads;
+			size_t k_hi = written * ( t + 1 ) / threads;
+			tasks[ t ].arr = arr;
+			tasks[ t ].batch = batch;
+			tasks[ t ].batch_lo = t == 0 ? 0 : tasks[ t - 1 ].batch_hi;
+			tasks[ t ].batch_hi = co_rank( arr + start, sorted_len - start, batch, batch_len, k_hi );
+			tasks[ t ].base_lo = start + k_lo - tasks[ t ].batch_lo;
+			tasks[ t ].base_hi = start + k_hi - tasks[ t ].batch_hi;
+			tasks[ t ].stats = sorting_statistics_create( 0 );
+
+			// The slice before this one writes up to its own end, which covers this many of this slice's base elements.
+			size_t overwritten = tasks[ t ].batch_lo;
+			tasks[ t ].saved_len = overwritten < tasks[ t ].base_hi - tasks[ t ].base_lo ? overwritten : tasks[ t ].base_hi - tasks[ t ].base_lo;
+			saved_total += tasks[ t ].saved_len;
+		}
+
+		saved = ( uint32_t * ) malloc( ( saved_total > 0 ? saved_total : 1 ) * sizeof( uint32_t ) );
+	}
+
+	if ( !saved ) { // Merge on the calling thread, which needs no saved elements.
+		threads = 1;
+		tasks = tasks ? tasks : ( MergeTask * ) calloc( 1, sizeof( MergeTask ) );
+	}
+
+	if ( !tasks ) {
+		free( handles );
+		free( started );
+		huge_free( batch, batch_len * sizeof( uint32_t ) );
+		SortingStatistics fallback = sort_large( arr, len, quicksort_recursive );
+		fallback.moves += stats.moves;
+		fallback.compares += stats.compares;
+
+		return fallback;
+	}
+
+	if ( !saved ) {
+		tasks[ 0 ] = ( MergeTask ) { .arr = arr, .batch = batch, .base_lo = start, .base_hi = sorted_len, .batch_lo = 0, .batch_hi = batch_len, .stats = sorting_statistics_create( 0 ) };
+	} else {
+		// Save every slice's overwritten base elements before any slice starts writing.
+		uint32_t *next = saved;
+
+		for ( uint32_t t = 0; t < threads; t++ ) {
+			tasks[ t ].saved = next;
+			memcpy( next, arr + tasks[ t ].base_lo, tasks[ t ].saved_len * sizeof( uint32_t ) );
+			stats.moves += tasks[ t ].saved_len;
+			next += tasks[ t ].saved_len;
+		}
+
+		for ( uint32_t t = 1; t < threads; t++ ) {
+			started[ t ] = pthread_create( &handles[ t ], NULL, merge_slice, &tasks[ t ] ) == 0;
+		}
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		if ( started && started[ t ] ) {
+			pthread_join( handles[ t ], NULL );
+		} else {
+			merge_slice( &tasks[ t ] );
+		}
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		stats.moves += tasks[ t ].stats.moves;
+		stats.compares += tasks[ t ].stats.compares;
+	}
+
+	free( tasks );
+	free( handles );
+	free( started );
+	free( saved );
+	huge_free( batch, batch_len * sizeof( uint32_t ) );
+
+	return stats;
+}
+
+// Description:
+// Adds a batch of new elements to a sorted array of 32-bit length. See merge_batch_large( ).
+//
+// Parameters:
+// uint32_t *arr - The array. Elements [0, sorted_len) are sorted and [sorted_len, len) are the new batch.
+// uint32_t sorted_len - The length of the sorted base.
+// uint32_t len - The length of the whole array.
+//
+// Returns:
+// SortingStatistics - The statistics for sorting the batch and merging it.
+SortingStatistics merge_batch( uint32_t *arr, uint32_t sorted_len, uint32_t len ) {
+	return merge_batch_large( arr, sorted_len, len );
+}
@@ -0,0 +1,15 @@
+#ifndef __MERGE_H__
+#define __MERGE_H__
+
+#include "sorting_statistics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+void merge_set_thread_count( uint32_t threads );
+
+SortingStatistics merge_batch( uint32_t *arr, uint32_t sorted_len, uint32_t len );
+
+SortingStatistics merge_batch_large( uint32_t *arr, size_t sorted_len, size_t len );
+
+#endif
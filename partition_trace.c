@@ -0,0 +1,306 @@
+#include "partition_trace.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#endif
+
+#define BALANCE_BUCKETS    10 // The number of buckets in the split-balance histogram (each covers 5% of a range).
+#define OCCUPANCY_SLICES   20 // The number of time slices in the work-list occupancy timeline.
+#define MAX_DEPTH_BUCKETS  64 // Depths at or past this are counted in the last depth histogram bucket.
+#define HISTOGRAM_BAR_SIZE 40 // The length of the bar for the largest bucket of a histogram.
+
+// Description:
+// One partition( ) call. Packed to 32 bytes so that records stay cheap to write.
+//
+// Members:
+// uint32_t lo - Starting point of the partitioned range.
+// uint32_t hi - Ending point of the partitioned range.
+// uint32_t split - The division of the range returned by partition( ).
+// uint32_t ds_size - The size of the work list (stack or queue, or the recursion depth) when the range was partitioned.
+// uint64_t compares - The number of compares done by the partition.
+// uint64_t cycles - The time taken by the partition, in CPU timestamp cycles (or nanoseconds on other CPUs).
+typedef struct {
+	uint32_t lo;
+	uint32_t hi;
+	uint32_t split;
+	uint32_t ds_size;
+	uint64_t compares;
+	uint64_t cycles;
+} PartitionRecord;
+
+// Description:
+// A struct for the PartitionTrace ADT, a ring buffer of the most recent partitions.
+//
+// Members:
+// uint64_t count - The number of partitions recorded since the trace was cleared, including overwritten ones.
+// uint32_t capacity - Capacity of the trace.
+// PartitionRecord *records - Holds the records; record i is at index i % capacity.
+struct PartitionTrace {
+	uint64_t count;
+	uint32_t capacity;
+	PartitionRecord *records;
+};
+
+// Description:
+// Initializes a trace with a specified capacity. All of its memory is allocated here so that recording
+// never allocates.
+//
+// Parameters:
+// uint32_t capacity - The max number of records kept.
+//
+// Returns:
+// PartitionTrace * - A pointer to the newly initialized trace.
+PartitionTrace *partition_trace_create( uint32_t capacity ) {
+	PartitionTrace *t = ( PartitionTrace * ) malloc( sizeof( PartitionTrace ) );
+
+	if ( t ) { // Make sure the memory allocated successfully to the struct.
+		t->count = 0;
+		t->capacity = capacity > 0 ? capacity : 1;
+		t->records = ( PartitionRecord * ) calloc( t->capacity, sizeof( PartitionRecord ) );
+
+		if ( !t->records ) { // t->records could not be allocated memory.
+			free( t );
+			t = NULL;
+		}
+	}
+
+	return t;
+}
+
+// Description:
+// Frees the memory given to a trace.
+//
+// Parameters:
+// PartitionTrace **t - A pointer to a pointer to the trace to free the memory of.
+//
+// Returns:
+// Nothing.
+void partition_trace_delete( PartitionTrace **t ) {
+	if ( *t && ( *t )->records ) { // Make sure the trace wasn't already deleted.
+		free( ( *t )->records );
+		free( *t );
+		*t = NULL;
+	}
+}
+
+// Description:
+// Removes every record from a trace.
+//
+// Parameters:
+// PartitionTrace *t - The trace to clear.
+//
+// Returns:
+// Nothing.
+void partition_trace_clear( PartitionTrace *t ) {
+	t->count = 0;
+}
+
+// Description:
+// Checks how many partitions have been recorded to a trace since it was cleared.
+//
+// Parameters:
+// PartitionTrace *t - The trace to check.
+//
+// Returns:
+// uint64_t - The number of partitions recorded, including ones that have been overwritten.
+uint64_t partition_trace_count( PartitionTrace *t ) {
+	return t->count;
+}
+
+// Description:
+// Reads the clock used to time partitions: the CPU timestamp counter on x86, or a monotonic clock in
+// nanoseconds elsewhere.
+//
+// Parameters:
+// Nothing.
+//
+// Returns:
+// uint64_t - The current time.
+uint64_t partition_trace_clock( ) {
+#if defined( __x86_64__ ) || defined( __i386__ )
+	return __rdtsc( );
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( uint64_t ) ts.tv_sec * 1000000000 + ( uint64_t ) ts.tv_nsec;
+#endif
+}
+
+// Description:
+// Records a partition, overwriting the oldest record if the trace is full.
+//
+// Parameters:
+// PartitionTrace *t - The trace to record to.
+// int64_t lo - Starting point of the partitioned range.
+// int64_t hi - Ending point of the partitioned range.
+// int64_t split - The division of the range.
+// uint64_t compares - The number of compares done by the partition.
+// uint64_t cycles - The time taken by the partition.
+// uint32_t ds_size - The size of the work list when the range was partitioned.
+//
+// Returns:
+// Nothing.
+void partition_trace_record( PartitionTrace *t, int64_t lo, int64_t hi, int64_t split, uint64_t compares, uint64_t cycles, uint32_t ds_size ) {
+	PartitionRecord *r = &t->records[ t->count % t->capacity ];
+	r->lo = ( uint32_t ) lo;
+	r->hi = ( uint32_t ) hi;
+	r->split = ( uint32_t ) split;
+	r->ds_size = ds_size;
+	r->compares = compares;
+	r->cycles = cycles;
+	t->count++;
+}
+
+// Description:
+// Orders records by starting point, with larger ranges first when they start at the same point.
+//
+// Parameters:
+// const void *a - A pointer to the first PartitionRecord *.
+// const void *b - A pointer to the second PartitionRecord *.
+//
+// Returns:
+// int - Negative, zero or positive if a comes before, with or after b.
+static int compare_by_range( const void *a, const void *b ) {
+	const PartitionRecord *x = *( const PartitionRecord * const * ) a;
+	const PartitionRecord *y = *( const PartitionRecord * const * ) b;
+
+	if ( x->lo != y->lo ) {
+		return x->lo < y->lo ? -1 : 1;
+	}
+
+	return x->hi == y->hi ? 0 : ( x->hi > y->hi ? -1 : 1 );
+}
+
+// Description:
+// Prints a histogram bar scaled to the largest bucket.
+//
+// Parameters:
+// FILE *out - The file to print to.
+// uint64_t value - The size of the bucket.
+// uint64_t max_value - The size of the largest bucket.
+//
+// Returns:
+// Nothing.
+static void print_bar( FILE *out, uint64_t value, uint64_t max_value ) {
+	uint64_t length = max_value > 0 ? ( value * HISTOGRAM_BAR_SIZE + max_value - 1 ) / max_value : 0;
+
+	for ( uint64_t i = 0; i < length; i++ ) {
+		fputc( '#', out );
+	}
+
+	fputc( '\n', out );
+}
+
+// Description:
+// Prints a report of a trace: the recursion depth histogram, the distribution of how evenly ranges were split,
+// and the work-list occupancy over time. Depths are recovered from how the recorded ranges nest, since ranges
+// in a quicksort partition tree are either nested or disjoint; if old records were overwritten, depths are
+// relative to the oldest range still recorded.
+//
+// Parameters:
+// PartitionTrace *t - The trace to report on.
+// FILE *out - The file to print to.
+//
+// Returns:
+// Nothing.
+void partition_trace_report( PartitionTrace *t, FILE *out ) {
+	uint32_t kept = t->count < t->capacity ? ( uint32_t ) t->count : t->capacity;
+	uint64_t first = t->count - kept; // The index of the oldest record still kept.
+	fprintf( out, "Partition trace: %" PRIu64 " partitions, %" PRIu32 " recorded\n", t->count, kept );
+
+	if ( kept == 0 ) {
+		return;
+	}
+
+	// Recursion depth: sweep the ranges in order, keeping a stack of the ranges that contain the current one.
+	uint64_t depth_counts[ MAX_DEPTH_BUCKETS ] = { 0 };
+	uint32_t max_depth = 0;
+	PartitionRecord **by_range = ( PartitionRecord ** ) calloc( kept, sizeof( PartitionRecord * ) );
+	PartitionRecord **ancestors = ( PartitionRecord ** ) calloc( kept, sizeof( PartitionRecord * ) );
+
+	if ( by_range && ancestors ) {
+		for ( uint32_t i = 0; i < kept; i++ ) {
+			by_range[ i ] = &t->records[ i ];
+		}
+
+		qsort( by_range, kept, sizeof( PartitionRecord * ), compare_by_range );
+		uint32_t depth = 0;
+
+		for ( uint32_t i = 0; i < kept; i++ ) {
+			while ( depth > 0 && ancestors[ depth - 1 ]->hi < by_range[ i ]->lo ) { // Left the ancestor's range.
+				depth--;
+			}
+
+			depth_counts[ depth < MAX_DEPTH_BUCKETS ? depth : MAX_DEPTH_BUCKETS - 1 ]++;
+			max_depth = depth > max_depth ? depth : max_depth;
+			ancestors[ depth++ ] = by_range[ i ];
+		}
+
+		uint64_t max_count = 0;
+
+		for ( uint32_t d = 0; d < MAX_DEPTH_BUCKETS; d++ ) {
+			max_count = depth_counts[ d ] > max_count ? depth_counts[ d ] : max_count;
+		}
+
+		fprintf( out, "Depth histogram (max depth %" PRIu32 "):\n", max_depth );
+
+		for ( uint32_t d = 0; d <= max_depth && d < MAX_DEPTH_BUCKETS; d++ ) {
+			fprintf( out, "   %3" PRIu32 "%s %10" PRIu64 " ", d, d == MAX_DEPTH_BUCKETS - 1 ? "+" : " ", depth_counts[ d ] );
+			print_bar( out, depth_counts[ d ], max_count );
+		}
+	}
+
+	free( by_range );
+	free( ancestors );
+
+	// Split balance: the smaller side's share of the range, in buckets of 5%.
+	uint64_t balance_counts[ BALANCE_BUCKETS ] = { 0 };
+	uint64_t balance_cycles[ BALANCE_BUCKETS ] = { 0 };
+	uint64_t max_balance_count = 0;
+
+	for ( uint32_t i = 0; i < kept; i++ ) {
+		PartitionRecord *r = &t->records[ i ];
+		uint64_t size = ( uint64_t ) r->hi - r->lo + 1;
+		uint64_t left = ( uint64_t ) r->split - r->lo + 1;
+		uint64_t smaller = left < size - left ? left : size - left;
+		uint32_t bucket = ( uint32_t ) ( smaller * 2 * BALANCE_BUCKETS / size );
+		bucket = bucket < BALANCE_BUCKETS ? bucket : BALANCE_BUCKETS - 1;
+		balance_counts[ bucket ]++;
+		balance_cycles[ bucket ] += r->cycles;
+		max_balance_count = balance_counts[ bucket ] > max_balance_count ? balance_counts[ bucket ] : max_balance_count;
+	}
+
+	fprintf( out, "Split balance (smaller side's share of the range, partitions and cycles):\n" );
+
+	for ( uint32_t b = 0; b < BALANCE_BUCKETS; b++ ) {
+		fprintf( out, "   %2" PRIu32 "-%2" PRIu32 "%% %10" PRIu64 " %14" PRIu64 " ", b * 50 / BALANCE_BUCKETS, ( b + 1 ) * 50 / BALANCE_BUCKETS, balance_counts[ b ], balance_cycles[ b ] );
+		print_bar( out, balance_counts[ b ], max_balance_count );
+	}
+
+	// Work-list occupancy: the mean and max size in equal slices of the recorded partitions, oldest first.
+	fprintf( out, "Work-list occupancy over time (mean / max per slice of partitions):\n" );
+	uint32_t slices = kept < OCCUPANCY_SLICES ? kept : OCCUPANCY_SLICES;
+
+	for ( uint32_t s = 0; s < slices; s++ ) {
+		uint32_t start = ( uint32_t ) ( ( uint64_t ) kept * s / slices );
+		uint32_t end = ( uint32_t ) ( ( uint64_t ) kept * ( s + 1 ) / slices );
+		uint64_t total = 0;
+		uint32_t max_size = 0;
+
+		for ( uint32_t i = start; i < end; i++ ) {
+			uint32_t size = t->records[ ( first + i ) % t->capacity ].ds_size;
+			total += size;
+			max_size = size > max_size ? size : max_size;
+		}
+
+		fprintf( out, "   %10" PRIu64 "-%-10" PRIu64 " %12.1f %10" PRIu32 "\n", first + start, first + end - 1, ( double ) total / ( end - start ), max_size );
+	}
+}
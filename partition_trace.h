@@ -0,0 +1,23 @@
+#ifndef __PARTITION_TRACE_H__
+#define __PARTITION_TRACE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct PartitionTrace PartitionTrace;
+
+PartitionTrace *partition_trace_create( uint32_t capacity );
+
+void partition_trace_delete( PartitionTrace **t );
+
+void partition_trace_clear( PartitionTrace *t );
+
+uint64_t partition_trace_count( PartitionTrace *t );
+
+uint64_t partition_trace_clock( );
+
+void partition_trace_record( PartitionTrace *t, int64_t lo, int64_t hi, int64_t split, uint64_t compares, uint64_t cycles, uint32_t ds_size );
+
+void partition_trace_report( PartitionTrace *t, FILE *out );
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __PIVOT_H__
+#define __PIVOT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MEDIAN_OF_THREE_COMPARES 3 // The number of compares median_of_three( ) does.
+#define NINTHER_COMPARES         12 // The number of compares ninther( ) does.
+
+// Description:
+// Finds the median of three keys.
+//
+// Parameters:
+// uint32_t a - The first key.
+// uint32_t b - The second key.
+// uint32_t c - The third key.
+//
+// Returns:
+// uint32_t - The median.
+static inline uint32_t median_of_three( uint32_t a, uint32_t b, uint32_t c ) {
+	uint32_t low = a < b ? a : b;
+	uint32_t high = a < b ? b : a;
+	uint32_t high_or_c = high < c ? high : c;
+
+	return low > high_or_c ? low : high_or_c;
+}
+
+// Description:
+// Finds the median of three 64-bit words, such as the packed key-index words argsort sorts.
+//
+// Parameters:
+// uint64_t a - The first word.
+// uint64_t b - The second word.
+// uint64_t c - The third word.
+//
+// Returns:
+// uint64_t - The median.
+static inline uint64_t median_of_three_words( uint64_t a, uint64_t b, uint64_t c ) {
+	uint64_t low = a < b ? a : b;
+	uint64_t high = a < b ? b : a;
+	uint64_t high_or_c = high < c ? high : c;
+
+	return low > high_or_c ? low : high_or_c;
+}
+
+// Description:
+// Finds Tukey's ninther of a range: the median of the medians of three groups of three keys spread evenly
+// over it. Inputs such as organ pipes fool a median of the ends and the middle into picking one of the
+// smallest keys every time, but not a ninther.
+//
+// Parameters:
+// const uint32_t *arr - The range.
+// size_t len - The length of the range (at least 1).
+//
+// Returns:
+// uint32_t - The ninther.
+static inline uint32_t ninther( const uint32_t *arr, size_t len ) {
+	size_t step = len / 8;
+	size_t mid = len / 2;
+	uint32_t first = median_of_three( arr[ 0 ], arr[ step ], arr[ 2 * step ] );
+	uint32_t middle = median_of_three( arr[ mid - step ], arr[ mid ], arr[ mid + step ] );
+	uint32_t last = median_of_three( arr[ len - 1 - 2 * step ], arr[ len - 1 - step ], arr[ len - 1 ] );
+
+	return median_of_three( first, middle, last );
+}
+
+#endif
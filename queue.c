@@ -1,6 +1,9 @@
 #include "queue.h"
 
+#include "huge_alloc.h"
+
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -8,16 +11,16 @@
 // A struct for the Queue ADT.
 //
 // Members:
-// uint32_t head - Index of the head of the queue.
-// uint32_t tail - Index of the tail of the queue.
-// uint32_t size - The number of elements in the queue.
-// uint32_t capacity - Capacity of the queue.
+// size_t head - Index of the head of the queue.
+// size_t tail - Index of the tail of the queue.
+// size_t size - The number of elements in the queue.
+// size_t capacity - Capacity of the queue.
 // int64_t *items - Holds the items.
 struct Queue {
-	uint32_t head;
-	uint32_t tail;
-	uint32_t size;
-	uint32_t capacity;
+	size_t head;
+	size_t tail;
+	size_t size;
+	size_t capacity;
 	int64_t *items;
 };
 
@@ -25,17 +28,17 @@ struct Queue {
 // Initializes a queue with a specified capacity.
 //
 // Parameters:
-// uint32_t capacity - The max capacity of the queue.
+// size_t capacity - The max capacity of the queue.
 //
 // Returns:
 // Queue * - A pointer to the newly initialized queue.
-Queue *queue_create( uint32_t capacity ) {
+Queue *queue_create( size_t capacity ) {
 	Queue *q = ( Queue * ) malloc( sizeof( Queue ) );
 
 	if ( q ) { // Make sure the memory allocated successfully to the struct.
 		q->head = q->size = q->tail = 0;
 		q->capacity = capacity;
-		q->items = ( int64_t * ) calloc( capacity, sizeof( int64_t ) );
+		q->items = capacity <= SIZE_MAX / sizeof( int64_t ) ? ( int64_t * ) huge_alloc( capacity * sizeof( int64_t ) ) : NULL;
 
 		if ( !q->items ) { // q->items could not be allocated memory.
 			free( q );
@@ -56,7 +59,7 @@ Queue *queue_create( uint32_t capacity ) {
 // Nothing.
 void queue_delete( Queue **q ) {
 	if ( *q && ( *q )->items ) { // Make sure the queue wasn't already deleted.
-		free( ( *q )->items );
+		huge_free( ( *q )->items, ( *q )->capacity * sizeof( int64_t ) );
 		free( *q );
 		*q = NULL;
 	}
@@ -93,8 +96,8 @@ bool queue_full( Queue *q ) {
 // Queue *q - The queue to check.
 //
 // Returns:
-// uint32_t - The size of the queue.
-uint32_t queue_size( Queue *q ) {
+// size_t - The size of the queue.
+size_t queue_size( Queue *q ) {
 	return q->size;
 }
 
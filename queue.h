@@ -2,11 +2,12 @@
 #define __QUEUE_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct Queue Queue;
 
-Queue *queue_create( uint32_t capacity );
+Queue *queue_create( size_t capacity );
 
 void queue_delete( Queue **q );
 
@@ -14,7 +15,7 @@ bool queue_empty( Queue *q );
 
 bool queue_full( Queue *q );
 
-uint32_t queue_size( Queue *q );
+size_t queue_size( Queue *q );
 
 bool queue_add( Queue *q, int64_t x );
 
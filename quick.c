@@ -1,26 +1,189 @@
 #include "quick.h"
 
+#include "concurrent_queue.h"
+#include "deque.h"
+#include "partition_trace.h"
+#include "pivot.h"
 #include "queue.h"
 #include "sorting_statistics.h"
 #include "stack.h"
+#include "tuning.h"
 
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+
+#define PARALLEL_CUTOFF 4096 // Ranges with fewer elements than this are sorted entirely by the thread that takes them.
+
+static uint32_t thread_count = 1;
+// The settings below are atomic because sorts on different threads each load them when they start.
+static _Atomic pivot_strategy pivot_choice = PIVOT_MIDDLE; // Set from the tuning profile at the start of each sort.
+static _Atomic uint32_t small_sort_cutoff = 0; // Set from the tuning profile at the start of each sort.
+static PartitionTrace *trace = NULL; // The trace set with quick_set_trace( ).
+static PartitionTrace *_Atomic active_trace = NULL; // The trace the running sort records to (NULL while multi-threaded).
+
+// Description:
+// The shared work pool of a multi-threaded quicksort.
+//
+// Members:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+// ConcurrentQueue *queue - Holds the packed ranges that still have to be partitioned.
+// _Atomic uint64_t pending - The number of ranges that are queued or being worked on.
+typedef struct {
+	uint32_t *arr;
+	uint32_t len;
+	ConcurrentQueue *queue;
+	_Atomic uint64_t pending;
+} WorkPool;
+
+// Description:
+// The shared state of a work-stealing quicksort.
+//
+// Members:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+// uint32_t threads - The number of threads sorting the array.
+// Deque **deques - The deque of packed ranges owned by each thread.
+// _Atomic uint64_t pending - The number of ranges that are in a deque or being worked on.
+typedef struct {
+	uint32_t *arr;
+	uint32_t len;
+	uint32_t threads;
+	Deque **deques;
+	_Atomic uint64_t pending;
+} StealPool;
+
+// Description:
+// One thread of a work-stealing quicksort.
+//
+// Members:
+// StealPool *pool - The state shared by all the threads.
+// uint32_t id - The index of this thread and its deque.
+// SortingStatistics stats - The statistics for the partitions done by this thread.
+typedef struct {
+	StealPool *pool;
+	uint32_t id;
+	SortingStatistics stats;
+} StealWorker;
+
+// Description:
+// One thread of a multi-threaded quicksort.
+//
+// Members:
+// WorkPool *pool - The work pool shared by all the threads.
+// SortingStatistics stats - The statistics for the partitions done by this thread.
+typedef struct {
+	WorkPool *pool;
+	SortingStatistics stats;
+} PoolWorker;
 
 // Description:
 // Sets the max_size if current_size is larger than the current max_size.
 //
 // Parameters:
-// uint32_t current_size - The current size.
-// uint32_t *max_size - The pointer to the current max size.
+// uint64_t current_size - The current size.
+// uint64_t *max_size - The pointer to the current max size.
 //
 // Returns:
 // Nothing.
-static void set_max_size( uint32_t current_size, uint32_t *max_size ) {
+static void set_max_size( uint64_t current_size, uint64_t *max_size ) {
 	if ( current_size > *max_size ) {
 		*max_size = current_size;
 	}
 }
 
+// Description:
+// Applies the active tuning profile and trace to the next sort.
+//
+// Parameters:
+// Nothing.
+//
+// Returns:
+// Nothing.
+static void load_tuning( ) {
+	const TuningProfile *profile = tuning_get( );
+	atomic_store_explicit( &active_trace, trace, memory_order_relaxed );
+	atomic_store_explicit( &pivot_choice, profile->pivot, memory_order_relaxed );
+	atomic_store_explicit( &small_sort_cutoff, profile->small_sort_cutoff, memory_order_relaxed );
+}
+
+// Description:
+// Picks the pivot for a partition using the tuned pivot strategy.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// uint32_t - The pivot.
+static uint32_t choose_pivot( uint32_t *arr, int64_t lo, int64_t hi, SortingStatistics *stats ) {
+	uint32_t middle = arr[ lo + ( ( hi - lo ) / 2 ) ];
+
+	// The median needs three distinct elements, or partition( ) could return hi and never shrink the range.
+	if ( atomic_load_explicit( &pivot_choice, memory_order_relaxed ) != PIVOT_MEDIAN_OF_THREE || hi - lo < 2 ) {
+		return middle;
+	}
+
+	stats->compares += MEDIAN_OF_THREE_COMPARES;
+
+	return median_of_three( arr[ lo ], middle, arr[ hi ] );
+}
+
+// Description:
+// Sorts a small range of an array with insertion sort.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// Nothing.
+static void insertion_sort( uint32_t *arr, int64_t lo, int64_t hi, SortingStatistics *stats ) {
+	for ( int64_t i = lo + 1; i <= hi; i++ ) {
+		int64_t j = i;
+		uint32_t temp = arr[ i ];
+
+		while ( j > lo && ++stats->compares && temp < arr[ j - 1 ] ) {
+			// Move arr[j - 1] to arr[j].
+			arr[ j ] = arr[ j - 1 ];
+			stats->moves++;
+			j -= 1;
+		}
+
+		arr[ j ] = temp;
+		stats->moves += 2;
+	}
+}
+
+// Description:
+// Insertion sorts a range if it is no larger than the tuned small-sort cutoff.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+//
+// Returns:
+// bool - Whether the range was sorted.
+static bool sort_small_range( uint32_t *arr, int64_t lo, int64_t hi, SortingStatistics *stats ) {
+	if ( hi - lo + 1 > atomic_load_explicit( &small_sort_cutoff, memory_order_relaxed ) ) {
+		return false;
+	}
+
+	insertion_sort( arr, lo, hi, stats );
+
+	return true;
+}
+
 // Description:
 // Places elements less than the pivot to the left side of the array and elements
 // greater than or equal to the pivot onto the right side of the array.
@@ -34,7 +197,7 @@ static void set_max_size( uint32_t current_size, uint32_t *max_size ) {
 // Returns:
 // int64_t - The division of the array.
 static int64_t partition( uint32_t *arr, int64_t lo, int64_t hi, SortingStatistics *stats ) {
-	uint32_t pivot = arr[ lo + ( ( hi - lo ) / 2 ) ];
+	uint32_t pivot = choose_pivot( arr, lo, hi, stats );
 	int64_t i = lo - 1;
 	int64_t j = hi + 1;
 
@@ -63,6 +226,45 @@ static int64_t partition( uint32_t *arr, int64_t lo, int64_t hi, SortingStatisti
 	return j;
 }
 
+// Description:
+// Partitions a range, recording the partition to the active trace if there is one.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to a SortingStatistics struct that will hold the stats of the sort.
+// uint32_t ds_size - The size of the work list, for the trace.
+//
+// Returns:
+// int64_t - The division of the array.
+static int64_t traced_partition( uint32_t *arr, int64_t lo, int64_t hi, SortingStatistics *stats, uint32_t ds_size ) {
+	PartitionTrace *t = atomic_load_explicit( &active_trace, memory_order_relaxed );
+
+	if ( !t ) {
+		return partition( arr, lo, hi, stats );
+	}
+
+	uint64_t compares = stats->compares;
+	uint64_t start = partition_trace_clock( );
+	int64_t p = partition( arr, lo, hi, stats );
+	partition_trace_record( t, lo, hi, p, stats->compares - compares, partition_trace_clock( ) - start, ds_size );
+
+	return p;
+}
+
+// Description:
+// Sets the trace the recursive, stack and queue quicksorts record each partition to.
+//
+// Parameters:
+// PartitionTrace *t - The trace to record to, or NULL to stop tracing.
+//
+// Returns:
+// Nothing.
+void quick_set_trace( PartitionTrace *t ) {
+	trace = t;
+}
+
 // Description:
 // Helper function for recursive quicksort.
 //
@@ -72,18 +274,23 @@ static int64_t partition( uint32_t *arr, int64_t lo, int64_t hi, SortingStatisti
 // int64_t lo - Starting point.
 // int64_t hi - Ending point.
 // SortingStatistics *stats - A pointer to the SortingStatistics struct that holds the sorting statistics.
+// uint32_t depth - The number of calls above this one, traced as the size of the work list.
 //
 // Returns:
 // Nothing.
-static void quicksort_recursive_internal( uint32_t *arr, uint32_t len, int64_t lo, int64_t hi, SortingStatistics *stats ) {
-	int64_t p = partition( arr, lo, hi, stats );
+static void quicksort_recursive_internal( uint32_t *arr, uint32_t len, int64_t lo, int64_t hi, SortingStatistics *stats, uint32_t depth ) {
+	if ( sort_small_range( arr, lo, hi, stats ) ) {
+		return;
+	}
+
+	int64_t p = traced_partition( arr, lo, hi, stats, depth );
 
 	if ( lo < p ) {
-		quicksort_recursive_internal( arr, len, lo, p, stats );
+		quicksort_recursive_internal( arr, len, lo, p, stats, depth + 1 );
 	}
 
 	if ( hi > p + 1 ) {
-		quicksort_recursive_internal( arr, len, p + 1, hi, stats );
+		quicksort_recursive_internal( arr, len, p + 1, hi, stats, depth + 1 );
 	}
 }
 
@@ -98,7 +305,8 @@ static void quicksort_recursive_internal( uint32_t *arr, uint32_t len, int64_t l
 // SortingStatistics - The statistics for the sort.
 SortingStatistics quicksort_recursive( uint32_t *arr, uint32_t len ) {
 	SortingStatistics stats = sorting_statistics_create( len );
-	quicksort_recursive_internal( arr, len, 0, len - 1, &stats );
+	load_tuning( );
+	quicksort_recursive_internal( arr, len, 0, ( int64_t ) len - 1, &stats, 0 );
 
 	return stats;
 }
@@ -115,7 +323,8 @@ SortingStatistics quicksort_recursive( uint32_t *arr, uint32_t len ) {
 SortingStatistics quicksort_stack( uint32_t *arr, uint32_t len ) {
 	SortingStatistics stats = sorting_statistics_create( len );
 	int64_t lo = 0;
-	int64_t hi = len - 1;
+	int64_t hi = ( int64_t ) len - 1;
+	load_tuning( );
 	Stack *stack = stack_create( len );
 	stack_push( stack, lo );
 	stack_push( stack, hi );
@@ -124,7 +333,12 @@ SortingStatistics quicksort_stack( uint32_t *arr, uint32_t len ) {
 	while ( !stack_empty( stack ) ) {
 		stack_pop( stack, &hi );
 		stack_pop( stack, &lo );
-		int64_t p = partition( arr, lo, hi, &stats );
+
+		if ( sort_small_range( arr, lo, hi, &stats ) ) {
+			continue;
+		}
+
+		int64_t p = traced_partition( arr, lo, hi, &stats, stack_size( stack ) );
 
 		if ( lo < p ) {
 			stack_push( stack, lo );
@@ -156,7 +370,8 @@ SortingStatistics quicksort_stack( uint32_t *arr, uint32_t len ) {
 SortingStatistics quicksort_queue( uint32_t *arr, uint32_t len ) {
 	SortingStatistics stats = sorting_statistics_create( len );
 	int64_t lo = 0;
-	int64_t hi = len - 1;
+	int64_t hi = ( int64_t ) len - 1;
+	load_tuning( );
 	Queue *queue = queue_create( len );
 	queue_add( queue, lo );
 	queue_add( queue, hi );
@@ -165,7 +380,12 @@ SortingStatistics quicksort_queue( uint32_t *arr, uint32_t len ) {
 	while ( !queue_empty( queue ) ) {
 		queue_remove( queue, &lo );
 		queue_remove( queue, &hi );
-		int64_t p = partition( arr, lo, hi, &stats );
+
+		if ( sort_small_range( arr, lo, hi, &stats ) ) {
+			continue;
+		}
+
+		int64_t p = traced_partition( arr, lo, hi, &stats, queue_size( queue ) );
 
 		if ( lo < p ) {
 			queue_add( queue, lo );
@@ -184,3 +404,328 @@ SortingStatistics quicksort_queue( uint32_t *arr, uint32_t len ) {
 
 	return stats;
 }
+
+// Description:
+// Sets the number of threads the next multi-threaded quicksort will use.
+//
+// Parameters:
+// uint32_t threads - The number of threads to use (0 is treated as 1).
+//
+// Returns:
+// Nothing.
+void quick_set_thread_count( uint32_t threads ) {
+	thread_count = threads > 0 ? threads : 1;
+}
+
+// Description:
+// Packs a range into one item so that it can be added to a concurrent data structure atomically.
+//
+// Parameters:
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+//
+// Returns:
+// int64_t - The packed range.
+static int64_t pack_range( int64_t lo, int64_t hi ) {
+	return ( int64_t ) ( ( ( uint64_t ) lo << 32 ) | ( uint32_t ) hi );
+}
+
+// Description:
+// Unpacks a range packed by pack_range( ).
+//
+// Parameters:
+// int64_t range - The packed range.
+// int64_t *lo - A pointer to a int64_t to set the starting point to.
+// int64_t *hi - A pointer to a int64_t to set the ending point to.
+//
+// Returns:
+// Nothing.
+static void unpack_range( int64_t range, int64_t *lo, int64_t *hi ) {
+	*lo = ( int64_t ) ( ( uint64_t ) range >> 32 );
+	*hi = ( int64_t ) ( ( uint64_t ) range & UINT32_MAX );
+}
+
+// Description:
+// Adds a range to a work pool, or sorts it on the calling thread if the pool is full.
+//
+// Parameters:
+// WorkPool *pool - The work pool to add to.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to the SortingStatistics struct of the calling thread.
+//
+// Returns:
+// Nothing.
+static void work_pool_add( WorkPool *pool, int64_t lo, int64_t hi, SortingStatistics *stats ) {
+	// Count the range before it can be taken, so that pending never drops to 0 while work is left.
+	atomic_fetch_add_explicit( &pool->pending, 1, memory_order_relaxed );
+
+	if ( !concurrent_queue_add( pool->queue, pack_range( lo, hi ) ) ) {
+		quicksort_recursive_internal( pool->arr, pool->len, lo, hi, stats, 0 );
+		atomic_fetch_sub_explicit( &pool->pending, 1, memory_order_release );
+	}
+}
+
+// Description:
+// Takes ranges from a work pool and partitions them until every range has been sorted.
+// Large ranges are split back into the pool; small ranges are sorted by this thread.
+//
+// Parameters:
+// void *arg - A pointer to the thread's PoolWorker.
+//
+// Returns:
+// void * - NULL.
+static void *work_pool_worker( void *arg ) {
+	PoolWorker *worker = ( PoolWorker * ) arg;
+	WorkPool *pool = worker->pool;
+	int64_t range = 0;
+	int64_t lo = 0;
+	int64_t hi = 0;
+
+	while ( true ) {
+		if ( !concurrent_queue_remove( pool->queue, &range ) ) {
+			if ( atomic_load_explicit( &pool->pending, memory_order_acquire ) == 0 ) { // Every range has been sorted.
+				break;
+			}
+
+			sched_yield( ); // Another thread is partitioning a range that may be split into the pool.
+
+			continue;
+		}
+
+		unpack_range( range, &lo, &hi );
+
+		if ( hi - lo + 1 < PARALLEL_CUTOFF ) {
+			quicksort_recursive_internal( pool->arr, pool->len, lo, hi, &worker->stats, 0 );
+		} else {
+			int64_t p = partition( pool->arr, lo, hi, &worker->stats );
+
+			if ( lo < p ) {
+				work_pool_add( pool, lo, p, &worker->stats );
+			}
+
+			if ( hi > p + 1 ) {
+				work_pool_add( pool, p + 1, hi, &worker->stats );
+			}
+
+			set_max_size( concurrent_queue_size( pool->queue ), &worker->stats.max_ds_size );
+		}
+
+		atomic_fetch_sub_explicit( &pool->pending, 1, memory_order_release );
+	}
+
+	return NULL;
+}
+
+// Description:
+// Uses quicksort to sort an array with multiple threads sharing a lock-free queue of ranges as a work pool.
+// The threads are set with quick_set_thread_count( ), but arrays smaller than the tuned parallel threshold
+// are sorted on one thread. The partitions done are the same as quicksort_queue( ),
+// so the moves and compares match it; the max data structure size counts ranges rather than indices.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics quicksort_concurrent_queue( uint32_t *arr, uint32_t len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	load_tuning( );
+	atomic_store_explicit( &active_trace, NULL, memory_order_relaxed ); // Traces are single-threaded.
+	uint32_t threads = len < tuning_get( )->parallel_threshold ? 1 : thread_count; // Small arrays are not worth splitting.
+	WorkPool pool = { .arr = arr, .len = len, .queue = concurrent_queue_create( len ) };
+	PoolWorker *workers = ( PoolWorker * ) calloc( threads, sizeof( PoolWorker ) );
+	pthread_t *handles = ( pthread_t * ) calloc( threads, sizeof( pthread_t ) );
+
+	if ( !pool.queue || !workers || !handles ) { // Fall back to a single-threaded quicksort rather than leave the array unsorted.
+		concurrent_queue_delete( &pool.queue );
+		free( workers );
+		free( handles );
+
+		return quicksort_queue( arr, len );
+	}
+
+	atomic_init( &pool.pending, 0 );
+	work_pool_add( &pool, 0, ( int64_t ) len - 1, &stats );
+	set_max_size( concurrent_queue_size( pool.queue ), &stats.max_ds_size );
+	uint32_t started = 1; // Thread 0 is the calling thread.
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		workers[ t ].pool = &pool;
+		workers[ t ].stats = sorting_statistics_create( 0 );
+	}
+
+	// Any threads that fail to start just leave more of the work to the others.
+	while ( started < threads && pthread_create( &handles[ started ], NULL, work_pool_worker, &workers[ started ] ) == 0 ) {
+		started++;
+	}
+
+	work_pool_worker( &workers[ 0 ] );
+
+	for ( uint32_t t = 1; t < started; t++ ) {
+		pthread_join( handles[ t ], NULL );
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		stats.moves += workers[ t ].stats.moves;
+		stats.compares += workers[ t ].stats.compares;
+		set_max_size( workers[ t ].stats.max_ds_size, &stats.max_ds_size );
+	}
+
+	concurrent_queue_delete( &pool.queue );
+	free( workers );
+	free( handles );
+
+	return stats;
+}
+
+// Description:
+// Pushes a range to a thread's own deque, or sorts it on the calling thread if the deque cannot grow.
+//
+// Parameters:
+// StealPool *pool - The shared state of the sort.
+// Deque *deque - The deque owned by the calling thread.
+// int64_t lo - Starting point.
+// int64_t hi - Ending point.
+// SortingStatistics *stats - A pointer to the SortingStatistics struct of the calling thread.
+//
+// Returns:
+// Nothing.
+static void steal_pool_push( StealPool *pool, Deque *deque, int64_t lo, int64_t hi, SortingStatistics *stats ) {
+	// Count the range before it can be stolen, so that pending never drops to 0 while work is left.
+	atomic_fetch_add_explicit( &pool->pending, 1, memory_order_relaxed );
+
+	if ( !deque_push( deque, pack_range( lo, hi ) ) ) {
+		quicksort_recursive_internal( pool->arr, pool->len, lo, hi, stats, 0 );
+		atomic_fetch_sub_explicit( &pool->pending, 1, memory_order_release );
+	}
+}
+
+// Description:
+// Partitions ranges from the thread's own deque depth-first, stealing the oldest (largest) range from
+// another thread whenever its own deque is empty, until every range has been sorted.
+//
+// Parameters:
+// void *arg - A pointer to the thread's StealWorker.
+//
+// Returns:
+// void * - NULL.
+static void *steal_pool_worker( void *arg ) {
+	StealWorker *worker = ( StealWorker * ) arg;
+	StealPool *pool = worker->pool;
+	Deque *own = pool->deques[ worker->id ];
+	int64_t range = 0;
+	int64_t lo = 0;
+	int64_t hi = 0;
+
+	while ( true ) {
+		bool found = deque_pop( own, &range );
+
+		for ( uint32_t k = 1; k < pool->threads && !found; k++ ) { // Look for a victim, starting with the next thread.
+			found = deque_steal( pool->deques[ ( worker->id + k ) % pool->threads ], &range );
+		}
+
+		if ( !found ) {
+			if ( atomic_load_explicit( &pool->pending, memory_order_acquire ) == 0 ) { // Every range has been sorted.
+				break;
+			}
+
+			sched_yield( ); // Other threads are partitioning ranges that may be pushed to their deques.
+
+			continue;
+		}
+
+		unpack_range( range, &lo, &hi );
+
+		if ( hi - lo + 1 < PARALLEL_CUTOFF ) {
+			quicksort_recursive_internal( pool->arr, pool->len, lo, hi, &worker->stats, 0 );
+		} else {
+			int64_t p = partition( pool->arr, lo, hi, &worker->stats );
+
+			if ( lo < p ) {
+				steal_pool_push( pool, own, lo, p, &worker->stats );
+			}
+
+			if ( hi > p + 1 ) {
+				steal_pool_push( pool, own, p + 1, hi, &worker->stats );
+			}
+
+			set_max_size( deque_size( own ), &worker->stats.max_ds_size );
+		}
+
+		atomic_fetch_sub_explicit( &pool->pending, 1, memory_order_release );
+	}
+
+	return NULL;
+}
+
+// Description:
+// Uses quicksort to sort an array with multiple threads, each working depth-first from its own
+// work-stealing deque of ranges. The threads are set with quick_set_thread_count( ), but arrays smaller than
+// the tuned parallel threshold are sorted on one thread. The partitions done
+// are the same as quicksort_stack( ), so the moves and compares match it; the max data structure size is
+// the largest single deque and counts ranges rather than indices.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics quicksort_work_stealing( uint32_t *arr, uint32_t len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+	load_tuning( );
+	atomic_store_explicit( &active_trace, NULL, memory_order_relaxed ); // Traces are single-threaded.
+	uint32_t threads = len < tuning_get( )->parallel_threshold ? 1 : thread_count; // Small arrays are not worth splitting.
+	StealPool pool = { .arr = arr, .len = len, .threads = threads };
+	pool.deques = ( Deque ** ) calloc( threads, sizeof( Deque * ) );
+	StealWorker *workers = ( StealWorker * ) calloc( threads, sizeof( StealWorker ) );
+	pthread_t *handles = ( pthread_t * ) calloc( threads, sizeof( pthread_t ) );
+	bool allocated = pool.deques && workers && handles;
+
+	for ( uint32_t t = 0; allocated && t < threads; t++ ) {
+		pool.deques[ t ] = deque_create( 0 );
+		allocated = pool.deques[ t ] != NULL;
+		workers[ t ].pool = &pool;
+		workers[ t ].id = t;
+		workers[ t ].stats = sorting_statistics_create( 0 );
+	}
+
+	if ( allocated ) {
+		atomic_init( &pool.pending, 0 );
+		steal_pool_push( &pool, pool.deques[ 0 ], 0, ( int64_t ) len - 1, &stats ); // Thread 0 is the calling thread.
+		uint32_t started = 1;
+
+		// Any threads that fail to start just leave more of the work to the others.
+		while ( started < threads && pthread_create( &handles[ started ], NULL, steal_pool_worker, &workers[ started ] ) == 0 ) {
+			started++;
+		}
+
+		steal_pool_worker( &workers[ 0 ] );
+
+		for ( uint32_t t = 1; t < started; t++ ) {
+			pthread_join( handles[ t ], NULL );
+		}
+
+		for ( uint32_t t = 0; t < threads; t++ ) {
+			stats.moves += workers[ t ].stats.moves;
+			stats.compares += workers[ t ].stats.compares;
+			set_max_size( workers[ t ].stats.max_ds_size, &stats.max_ds_size );
+		}
+	}
+
+	for ( uint32_t t = 0; pool.deques && t < threads; t++ ) {
+		deque_delete( &pool.deques[ t ] );
+	}
+
+	free( pool.deques );
+	free( workers );
+	free( handles );
+
+	if ( !allocated ) { // Fall back to a single-threaded quicksort rather than leave the array unsorted.
+		return quicksort_stack( arr, len );
+	}
+
+	return stats;
+}
@@ -1,6 +1,7 @@
 #ifndef __QUICK_H__
 #define __QUICK_H__
 
+#include "partition_trace.h"
 #include "sorting_statistics.h"
 
 #include <stdint.h>
@@ -11,4 +12,12 @@ SortingStatistics quicksort_stack( uint32_t *arr, uint32_t len );
 
 SortingStatistics quicksort_queue( uint32_t *arr, uint32_t len );
 
+void quick_set_trace( PartitionTrace *t );
+
+void quick_set_thread_count( uint32_t threads );
+
+SortingStatistics quicksort_concurrent_queue( uint32_t *arr, uint32_t len );
+
+SortingStatistics quicksort_work_stealing( uint32_t *arr, uint32_t len );
+
 #endif
@@ -0,0 +1,203 @@
+#define _GNU_SOURCE // For sched_getaffinity( ) and the CPU_* macros.
+
+#include "scheduler.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SIBLINGS_PATH "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list" // Lists a CPU's hyperthreads.
+
+// Description:
+// The shared state of a scheduler run.
+//
+// Members:
+// SchedulerJob *jobs - The jobs.
+// uint32_t *order - The indices of the jobs in the order they are started.
+// uint32_t count - The number of jobs.
+// atomic_uint next - The position in order of the next job to start.
+typedef struct {
+	SchedulerJob *jobs;
+	uint32_t *order;
+	uint32_t count;
+	atomic_uint next;
+} Schedule;
+
+// Description:
+// A thread that runs jobs pinned to one CPU.
+//
+// Members:
+// Schedule *schedule - The shared state of the run.
+// uint32_t cpu - The CPU the thread is pinned to.
+typedef struct {
+	Schedule *schedule;
+	uint32_t cpu;
+} SchedulerWorker;
+
+// Description:
+// Checks whether a CPU is the first hyperthread of its core. CPUs whose topology cannot be read count as
+// first, so the check never hides a CPU it knows nothing about.
+//
+// Parameters:
+// uint32_t cpu - The CPU to check.
+//
+// Returns:
+// bool - Whether the CPU is the first of its siblings.
+static bool first_sibling( uint32_t cpu ) {
+	char path[ 128 ];
+	snprintf( path, sizeof( path ), SIBLINGS_PATH, cpu );
+	FILE *file = fopen( path, "r" );
+	unsigned int first = cpu;
+
+	if ( file ) {
+		// The list starts with the lowest sibling, as in "2,66" or "2-3".
+		if ( fscanf( file, "%u", &first ) != 1 ) {
+			first = cpu;
+		}
+
+		fclose( file );
+	}
+
+	return first == cpu;
+}
+
+// Description:
+// Lists the CPUs this process may run on.
+//
+// Parameters:
+// bool skip_siblings - Whether to list only the first hyperthread of each core, so the others stay idle.
+// uint32_t *cpus - Set to the CPUs.
+// uint32_t max - The most CPUs to list.
+//
+// Returns:
+// uint32_t - The number of CPUs listed (0 if the affinity mask could not be read).
+uint32_t scheduler_cpus( bool skip_siblings, uint32_t *cpus, uint32_t max ) {
+	cpu_set_t set;
+	uint32_t count = 0;
+
+	if ( sched_getaffinity( 0, sizeof( set ), &set ) != 0 ) {
+		return 0;
+	}
+
+	for ( uint32_t cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++ ) {
+		if ( CPU_ISSET( cpu, &set ) && ( !skip_siblings || first_sibling( cpu ) ) ) {
+			cpus[ count++ ] = cpu;
+		}
+	}
+
+	return count;
+}
+
+// Description:
+// Pins the calling thread to one CPU. A thread that cannot be pinned just runs unpinned.
+//
+// Parameters:
+// uint32_t cpu - The CPU.
+//
+// Returns:
+// Nothing.
+static void pin_to_cpu( uint32_t cpu ) {
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	CPU_SET( cpu, &set );
+	sched_setaffinity( 0, sizeof( set ), &set );
+}
+
+// Description:
+// Pins itself to its CPU, then runs jobs until there are none left.
+//
+// Parameters:
+// void *arg - A pointer to the SchedulerWorker.
+//
+// Returns:
+// void * - NULL.
+static void *scheduler_worker( void *arg ) {
+	SchedulerWorker *worker = ( SchedulerWorker * ) arg;
+	Schedule *schedule = worker->schedule;
+	pin_to_cpu( worker->cpu );
+
+	for ( uint32_t i = atomic_fetch_add( &schedule->next, 1 ); i < schedule->count; i = atomic_fetch_add( &schedule->next, 1 ) ) {
+		SchedulerJob *job = &schedule->jobs[ schedule->order[ i ] ];
+		job->run( job->arg );
+	}
+
+	return NULL;
+}
+
+// Description:
+// Runs independent jobs concurrently, one thread per CPU with each thread pinned to its CPU. Costlier jobs
+// start first so that one long job does not run alone at the end. The calling thread runs jobs as well,
+// and its CPU affinity is restored afterward. Jobs started on one thread finish before the next starts
+// there, so a job may use its whole CPU.
+//
+// Parameters:
+// SchedulerJob *jobs - The jobs.
+// uint32_t count - The number of jobs.
+// bool skip_siblings - Whether to leave all but one hyperthread of each core idle.
+//
+// Returns:
+// bool - Whether the jobs were run (false if memory or the CPUs could not be read).
+bool scheduler_run( SchedulerJob *jobs, uint32_t count, bool skip_siblings ) {
+	cpu_set_t old_affinity;
+	uint32_t *cpus = ( uint32_t * ) calloc( CPU_SETSIZE, sizeof( uint32_t ) );
+	uint32_t *order = ( uint32_t * ) calloc( count > 0 ? count : 1, sizeof( uint32_t ) );
+	uint32_t cpu_count = cpus ? scheduler_cpus( skip_siblings, cpus, CPU_SETSIZE ) : 0;
+	uint32_t threads = cpu_count < count ? cpu_count : count;
+	SchedulerWorker *workers = ( SchedulerWorker * ) calloc( threads > 0 ? threads : 1, sizeof( SchedulerWorker ) );
+	pthread_t *handles = ( pthread_t * ) calloc( threads > 0 ? threads : 1, sizeof( pthread_t ) );
+
+	if ( !order || cpu_count == 0 || !workers || !handles || sched_getaffinity( 0, sizeof( old_affinity ), &old_affinity ) != 0 ) {
+		free( cpus );
+		free( order );
+		free( workers );
+		free( handles );
+
+		return false;
+	}
+
+	// Order the jobs by cost, most expensive first, keeping equal jobs in their given order.
+	for ( uint32_t i = 0; i < count; i++ ) {
+		uint32_t j = i;
+
+		while ( j > 0 && jobs[ order[ j - 1 ] ].cost < jobs[ i ].cost ) {
+			order[ j ] = order[ j - 1 ];
+			j--;
+		}
+
+		order[ j ] = i;
+	}
+
+	Schedule schedule = { .jobs = jobs, .order = order, .count = count };
+	atomic_init( &schedule.next, 0 );
+	uint32_t started = 1; // Worker 0 is the calling thread.
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		workers[ t ].schedule = &schedule;
+		workers[ t ].cpu = cpus[ t ];
+	}
+
+	// Any threads that fail to start just leave more of the jobs to the others.
+	while ( started < threads && pthread_create( &handles[ started ], NULL, scheduler_worker, &workers[ started ] ) == 0 ) {
+		started++;
+	}
+
+	if ( threads > 0 ) {
+		scheduler_worker( &workers[ 0 ] );
+	}
+
+	for ( uint32_t t = 1; t < started; t++ ) {
+		pthread_join( handles[ t ], NULL );
+	}
+
+	sched_setaffinity( 0, sizeof( old_affinity ), &old_affinity );
+	free( cpus );
+	free( order );
+	free( workers );
+	free( handles );
+
+	return true;
+}
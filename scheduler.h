@@ -0,0 +1,19 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct SchedulerJob SchedulerJob;
+
+struct SchedulerJob {
+	void ( *run )( void *arg ); // Runs the job.
+	void *arg; // The argument the job is run with.
+	double cost; // The expected cost of the job relative to the others. Costlier jobs start first.
+};
+
+uint32_t scheduler_cpus( bool skip_siblings, uint32_t *cpus, uint32_t max );
+
+bool scheduler_run( SchedulerJob *jobs, uint32_t count, bool skip_siblings );
+
+#endif
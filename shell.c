@@ -1,15 +1,56 @@
 #include "shell.h"
 
+#include "gap_sequences.h"
 #include "sorting_statistics.h"
+#include "tuning.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+#define LARGE_GAP          1024 // Gaps at least this large put each element of a chain on a different page.
+#define INTERLEAVED_CHAINS 4 // The number of chains a large-gap pass inserts into at once (must not exceed LARGE_GAP).
+#define PREFETCH_DISTANCE  64 // How many elements ahead of the current position to prefetch for.
+
 const uint32_t *gap_seq = NULL;
 uint32_t gap_seq_len = 0;
 
 // Description:
-// Sets the gap sequence for the next shell sort to use.
+// Gets the gap sequence from the tuning profile.
+//
+// Parameters:
+// uint32_t *len - A pointer to a uint32_t to set the length of the gap sequence to.
+//
+// Returns:
+// const uint32_t * - The gap sequence.
+static const uint32_t *tuned_gap_sequence( uint32_t *len ) {
+	bool pratt = tuning_get( )->gaps == GAP_SEQ_PRATT;
+	*len = pratt ? PRATT_GAP_SEQ_SIZE : CIURA_GAP_SEQ_SIZE;
+
+	return pratt ? pratt_gap_seq : ciura_gap_seq;
+}
+
+// Description:
+// Gets the gap sequence to sort with: the one that was set, or the tuned one if none was set.
+//
+// Parameters:
+// uint32_t *len - A pointer to a uint32_t to set the length of the gap sequence to.
+//
+// Returns:
+// const uint32_t * - The gap sequence.
+static const uint32_t *active_gap_sequence( uint32_t *len ) {
+	if ( gap_seq ) {
+		*len = gap_seq_len;
+
+		return gap_seq;
+	}
+
+	return tuned_gap_sequence( len );
+}
+
+// Description:
+// Sets the gap sequence for the next shell sort to use. A NULL gap sequence makes shell sort use the
+// gap sequence from the tuning profile.
 //
 // Parameters:
 // uint32_t *gap_seq - The gap sequence to use.
@@ -23,35 +64,230 @@ void shell_set_gap_sequence( const uint32_t *gs, uint32_t gs_len ) {
 }
 
 // Description:
-// Uses shell sort to sort an array.
+// Does one gapped insertion sort pass over an array, one element at a time.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+// uint32_t start - The first element to insert.
+// uint32_t gap - The gap to use.
+// SortingStatistics *stats - A pointer to the SortingStatistics struct that holds the sorting statistics.
+//
+// Returns:
+// Nothing.
+static void shell_pass( uint32_t *arr, uint32_t len, uint32_t start, uint32_t gap, SortingStatistics *stats ) {
+	for ( uint32_t i = start; i < len; i++ ) {
+		uint32_t j = i;
+		uint32_t temp = arr[ i ];
+
+		while ( j >= gap && ++stats->compares && temp < arr[ j - gap ] ) {
+			// Move arr[j] to arr[j - gap]
+			arr[ j ] = arr[ j - gap ];
+			stats->moves++;
+			j -= gap;
+		}
+
+		arr[ j ] = temp;
+		stats->moves += 2;
+	}
+}
+
+// Description:
+// Does one gapped insertion sort pass over an array, inserting INTERLEAVED_CHAINS consecutive elements at once.
+// Consecutive elements belong to different chains when the gap is at least INTERLEAVED_CHAINS, so their
+// insertions are independent and can be stepped in lockstep, letting the cache misses of each chain overlap.
+// Produces the same array and statistics as shell_pass( ).
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+// uint32_t gap - The gap to use (must be at least INTERLEAVED_CHAINS).
+// SortingStatistics *stats - A pointer to the SortingStatistics struct that holds the sorting statistics.
+//
+// Returns:
+// Nothing.
+static void shell_pass_interleaved( uint32_t *arr, uint32_t len, uint32_t gap, SortingStatistics *stats ) {
+	uint32_t i = gap;
+
+	for ( ; i < len && len - i >= INTERLEAVED_CHAINS; i += INTERLEAVED_CHAINS ) {
+		uint32_t j[ INTERLEAVED_CHAINS ];
+		uint32_t temp[ INTERLEAVED_CHAINS ];
+		uint32_t active = ( 1u << INTERLEAVED_CHAINS ) - 1; // Bit k is set while chain k is still being inserted into.
+
+		// Prefetch the first two elements each upcoming insertion will compare against.
+		if ( len - i > PREFETCH_DISTANCE ) {
+			__builtin_prefetch( &arr[ i + PREFETCH_DISTANCE - gap ], 1 );
+
+			if ( i + PREFETCH_DISTANCE >= 2 * gap ) {
+				__builtin_prefetch( &arr[ i + PREFETCH_DISTANCE - 2 * gap ], 1 );
+			}
+		}
+
+		for ( uint32_t k = 0; k < INTERLEAVED_CHAINS; k++ ) {
+			j[ k ] = i + k;
+			temp[ k ] = arr[ i + k ];
+		}
+
+		while ( active ) {
+			for ( uint32_t k = 0; k < INTERLEAVED_CHAINS; k++ ) {
+				if ( !( active & ( 1u << k ) ) ) {
+					continue;
+				}
+
+				if ( j[ k ] >= gap && ++stats->compares && temp[ k ] < arr[ j[ k ] - gap ] ) {
+					// Move arr[j] to arr[j - gap]
+					arr[ j[ k ] ] = arr[ j[ k ] - gap ];
+					stats->moves++;
+					j[ k ] -= gap;
+				} else {
+					arr[ j[ k ] ] = temp[ k ];
+					stats->moves += 2;
+					active &= ~( 1u << k );
+				}
+			}
+		}
+	}
+
+	shell_pass( arr, len, i, gap, stats ); // Insert the elements left over after the last full group.
+}
+
+// Description:
+// Uses shell sort to sort an array with a given gap sequence.
 //
 // Parameters:
 // uint32_t *arr - The array to sort.
 // uint32_t len - The length of the array to sort.
+// const uint32_t *gaps - The gap sequence.
+// uint32_t gaps_len - The length of the gap sequence.
 //
 // Returns:
 // SortingStatistics - The statistics for the sort.
-SortingStatistics shell_sort( uint32_t *arr, uint32_t len ) {
+static SortingStatistics shell_sort_gaps( uint32_t *arr, uint32_t len, const uint32_t *gaps, uint32_t gaps_len ) {
 	SortingStatistics stats = sorting_statistics_create( len );
 
-	for ( uint32_t gap_index = 0; gap_index < gap_seq_len; gap_index++ ) {
-		uint32_t gap = gap_seq[ gap_index ];
+	for ( uint32_t gap_index = 0; gap_index < gaps_len; gap_index++ ) {
+		shell_pass( arr, len, gaps[ gap_index ], gaps[ gap_index ], &stats );
+	}
 
-		for ( uint32_t i = gap; i < len; i++ ) {
-			uint32_t j = i;
-			uint32_t temp = arr[ i ];
+	return stats;
+}
 
-			while ( j >= gap && ++stats.compares && temp < arr[ j - gap ] ) {
-				// Move arr[j] to arr[j - gap]
-				arr[ j ] = arr[ j - gap ];
-				stats.moves++;
-				j -= gap;
-			}
+// Description:
+// Uses shell sort to sort an array with a given gap sequence, with cache-conscious passes for large gaps.
+// Passes with a gap of at least LARGE_GAP insert into several chains at once and prefetch ahead,
+// since each of their compares is otherwise a dependent cache and TLB miss.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+// const uint32_t *gaps - The gap sequence.
+// uint32_t gaps_len - The length of the gap sequence.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+static SortingStatistics shell_sort_cache_aware_gaps( uint32_t *arr, uint32_t len, const uint32_t *gaps, uint32_t gaps_len ) {
+	SortingStatistics stats = sorting_statistics_create( len );
+
+	for ( uint32_t gap_index = 0; gap_index < gaps_len; gap_index++ ) {
+		uint32_t gap = gaps[ gap_index ];
 
-			arr[ j ] = temp;
-			stats.moves += 2;
+		if ( gap >= LARGE_GAP ) {
+			shell_pass_interleaved( arr, len, gap, &stats );
+		} else {
+			shell_pass( arr, len, gap, gap, &stats );
 		}
 	}
 
 	return stats;
 }
+
+// Description:
+// Uses shell sort to sort an array with the gap sequence that was set, or the tuned one if none was set.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics shell_sort( uint32_t *arr, uint32_t len ) {
+	uint32_t gaps_len = 0;
+	const uint32_t *gaps = active_gap_sequence( &gaps_len );
+
+	return shell_sort_gaps( arr, len, gaps, gaps_len );
+}
+
+// Description:
+// Uses cache-aware shell sort to sort an array with the gap sequence that was set, or the tuned one if none was set.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics shell_sort_cache_aware( uint32_t *arr, uint32_t len ) {
+	uint32_t gaps_len = 0;
+	const uint32_t *gaps = active_gap_sequence( &gaps_len );
+
+	return shell_sort_cache_aware_gaps( arr, len, gaps, gaps_len );
+}
+
+// Description:
+// Uses shell sort to sort an array with the Ciura gap sequence. Ignores the set gap sequence, so it is
+// safe to run alongside other shell sorts.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics shell_sort_ciura( uint32_t *arr, uint32_t len ) {
+	return shell_sort_gaps( arr, len, ciura_gap_seq, CIURA_GAP_SEQ_SIZE );
+}
+
+// Description:
+// Uses shell sort to sort an array with the Pratt gap sequence. Ignores the set gap sequence, so it is
+// safe to run alongside other shell sorts.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics shell_sort_pratt( uint32_t *arr, uint32_t len ) {
+	return shell_sort_gaps( arr, len, pratt_gap_seq, PRATT_GAP_SEQ_SIZE );
+}
+
+// Description:
+// Uses shell sort to sort an array with the gap sequence from the tuning profile. Ignores the set gap
+// sequence, so it is safe to run alongside other shell sorts.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics shell_sort_tuned( uint32_t *arr, uint32_t len ) {
+	uint32_t gaps_len = 0;
+	const uint32_t *gaps = tuned_gap_sequence( &gaps_len );
+
+	return shell_sort_gaps( arr, len, gaps, gaps_len );
+}
+
+// Description:
+// Uses cache-aware shell sort to sort an array with the Pratt gap sequence. Ignores the set gap sequence,
+// so it is safe to run alongside other shell sorts.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort.
+SortingStatistics shell_sort_cache_aware_pratt( uint32_t *arr, uint32_t len ) {
+	return shell_sort_cache_aware_gaps( arr, len, pratt_gap_seq, PRATT_GAP_SEQ_SIZE );
+}
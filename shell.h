@@ -9,4 +9,14 @@ void shell_set_gap_sequence( const uint32_t *gs, uint32_t gs_len );
 
 SortingStatistics shell_sort( uint32_t *arr, uint32_t len );
 
+SortingStatistics shell_sort_cache_aware( uint32_t *arr, uint32_t len );
+
+SortingStatistics shell_sort_ciura( uint32_t *arr, uint32_t len );
+
+SortingStatistics shell_sort_pratt( uint32_t *arr, uint32_t len );
+
+SortingStatistics shell_sort_cache_aware_pratt( uint32_t *arr, uint32_t len );
+
+SortingStatistics shell_sort_tuned( uint32_t *arr, uint32_t len );
+
 #endif
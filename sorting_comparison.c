@@ -1,38 +1,156 @@
+#include "argsort.h"
+#include "autotune.h"
 #include "bubble.h"
+#include "dedup.h"
+#include "fast_io.h"
 #include "gap_sequences.h"
+#include "huge_alloc.h"
+#include "large_sort.h"
+#include "merge.h"
+#include "partition_trace.h"
 #include "quick.h"
+#include "scheduler.h"
 #include "set.h"
 #include "shell.h"
 #include "sorting_statistics.h"
+#include "tuning.h"
+#include "verify.h"
 
 #include <getopt.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #define DEFAULT_ARRAY_LENGTH 100 // The number of array elements to generate.
 #define DEFAULT_MAX_TO_PRINT 100 // The max number of elements to print.
 #define DEFAULT_RANDOM_SEED  1000 // The default random seed for generating array elements.
-#define OPTIONS              "habsSqtQn:p:r:" // Valid options for the program.
+#define DEFAULT_PROFILE_PATH "sorting_profile.txt" // Where autotuning saves the profile if no path is given.
+#define AUTOTUNE_LENGTH      ( 1 << 20 ) // The number of array elements to autotune with if no length is given.
+#define OUTPUT_BUFFER_SIZE   ( 1 << 22 ) // The size of the buffer sorted elements are printed through.
+#define MAX_LIST_LENGTH      16 // The most array lengths or seeds that can be given to -n or -r.
+#define OPTIONS              "habBcesSPlqtQwdguUAvCHWn:p:r:i:o:j:F:T:I:k:G:" // Valid options for the program.
 
 // An enum for sort flags.
-typedef enum { F_ALL, F_BUBBLE, F_SHELL_CIURA, F_SHELL_PRATT, F_QUICK_RECURSIVE, F_QUICK_STACK, F_QUICK_QUEUE } flags;
+typedef enum { F_ALL, F_BUBBLE, F_BUBBLE_LAST_SWAP, F_COCKTAIL, F_ODD_EVEN, F_SHELL_CIURA, F_SHELL_PRATT, F_SHELL_PRATT_CACHE, F_SHELL_TUNED, F_QUICK_RECURSIVE, F_QUICK_STACK, F_QUICK_QUEUE, F_QUICK_CONCURRENT_QUEUE, F_QUICK_WORK_STEALING, F_ARGSORT, F_INCREMENTAL_MERGE, F_UNIQUE, F_COUNTS } flags;
+
+// An enum for the formats sorted elements can be printed in.
+typedef enum { FORMAT_TABLE, FORMAT_LINES } output_format;
+
+// An enum for the patterns generated elements can follow.
+typedef enum { PATTERN_RANDOM, PATTERN_ORGAN_PIPE } input_pattern;
+
+// Description:
+// Settings shared by every sort the program runs.
+//
+// Members:
+// uint32_t max_to_print - The max number of elements to print.
+// output_format format - The format to print the sorted elements in.
+// FastWriter *out - The writer to print the sorted elements through.
+// bool verify - Whether to check that each sort's output is a sorted permutation of the input.
+// uint32_t threads - The number of threads for parallel sorts and verification.
+// MultisetHash input_hash - The multiset hash of the input (only set if verify is true).
+// PartitionTrace *trace - The trace quicksort partitions are recorded to, or NULL if tracing is off.
+// uint32_t key_range - Generated elements are less than this (0 for no limit).
+// input_pattern pattern - The pattern generated elements follow.
+// bool large - Whether to run the sorts through their size_t-length entry points.
+typedef struct {
+	uint32_t max_to_print;
+	output_format format;
+	FastWriter *out;
+	bool verify;
+	uint32_t threads;
+	MultisetHash input_hash;
+	PartitionTrace *trace;
+	uint32_t key_range;
+	input_pattern pattern;
+	bool large;
+} RunConfig;
+
+// Description:
+// A sort the program can run.
+//
+// Members:
+// flags flag - The flag that enables the sort.
+// char *name - The name of the sort.
+// SortingStatistics ( *sort_function )( uint32_t *, uint32_t ) - The sort.
+// bool quadratic - Whether the sort takes quadratic time (used to start long scheduled jobs first).
+typedef struct {
+	flags flag;
+	char *name;
+	SortingStatistics ( *sort_function )( uint32_t *, uint32_t );
+	bool quadratic;
+} SortEntry;
 
 // Description:
-// Fills an array's elements with pseudorandom numbers based on a seed.
+// One sort of one array, run on its own CPU in scheduler mode.
+//
+// Members:
+// const SortEntry *sort - The sort to run.
+// uint32_t len - The length of the array.
+// uint32_t seed - The seed to generate the array with.
+// uint32_t key_range - Generated elements are less than this (0 for no limit).
+// input_pattern pattern - The pattern generated elements follow.
+// const uint32_t *input - The elements to sort, or NULL to generate them from the seed.
+// bool verify - Whether to check the sort's output.
+// uint32_t head_len - The number of sorted elements to keep for printing.
+// bool ran - Set to whether the job could allocate its arrays and run.
+// SortingStatistics stats - Set to the statistics of the sort.
+// double elapsed - Set to the time the sort took in seconds.
+// bool verified - Set to whether the output was a sorted permutation of the input (if verify is true).
+// uint32_t *head - Set to the first head_len sorted elements.
+typedef struct {
+	const SortEntry *sort;
+	uint32_t len;
+	uint32_t seed;
+	uint32_t key_range;
+	input_pattern pattern;
+	const uint32_t *input;
+	bool verify;
+	uint32_t head_len;
+	bool ran;
+	SortingStatistics stats;
+	double elapsed;
+	bool verified;
+	uint32_t *head;
+} SortJob;
+
+// Description:
+// Fills an array's elements with pseudorandom numbers based on a seed, or with an organ pipe that rises
+// from 0 to half the length and falls back to 1.
 //
 // Parameters:
 // uint32_t *arr - The array to fill.
 // uint32_t seed - The seed to use to generate pseudorandom numbers.
 // uint32_t length - The length of the array.
+// uint32_t key_range - Every element is less than this (0 for no limit).
+// input_pattern pattern - The pattern to fill the array with.
 //
 // Returns:
 // Nothing.
-static void generate_random_array( uint32_t *arr, uint32_t seed, uint32_t length ) {
-	srandom( seed );
+static void generate_array( uint32_t *arr, uint32_t seed, uint32_t length, uint32_t key_range, input_pattern pattern ) {
+	if ( pattern == PATTERN_ORGAN_PIPE ) {
+		for ( uint32_t i = 0; i < length; i++ ) {
+			uint32_t x = i < length / 2 ? i : length - i;
+			arr[ i ] = key_range > 0 ? x % key_range : x;
+		}
+
+		return;
+	}
+
+	// random_r( ) with the default state size gives the same numbers as random( ) without sharing its state
+	// between threads.
+	char state[ 128 ];
+	struct random_data data;
+	memset( &data, 0, sizeof( data ) );
+	initstate_r( seed, state, sizeof( state ), &data );
 
 	for ( uint32_t i = 0; i < length; i++ ) {
-		arr[ i ] = random( );
+		int32_t x = 0;
+		random_r( &data, &x );
+		arr[ i ] = key_range > 0 ? ( uint32_t ) x % key_range : ( uint32_t ) x;
 	}
 }
 
@@ -46,12 +164,13 @@ static void generate_random_array( uint32_t *arr, uint32_t seed, uint32_t length
 // Nothing.
 static void print_help( char *program_path ) {
 	fprintf( stderr,
-	    "SYNOPSIS\n   Compares sorting algorithms against each other. Uses a random\n   seed to generate elements to sort.\n\nUSAGE\n   %s [-habsSqtQ] [-n length] [-p elements] [-r "
-	    "seed]\n\nOPTIONS\n   -h              Prints the help text.\n   -a              Enables all sorts.\n   -b              Enables bubble sort.\n   -s              Enables shell sort (Ciura gap "
-	    "sequence).\n   -S              Enables shell sort (Pratt gap sequence).\n   -q              Enables quicksort (recursive).\n   -t              Enables quicksort (stack).\n   -Q              "
-	    "Enables quicksort (queue).\n   -n length       Number of array elements to generate.\n   -p elements     Number of total elements to print.\n   -r seed         Random seed used to generate "
-	    "array elements.\n",
-	    program_path );
+	    "SYNOPSIS\n   Compares sorting algorithms against each other. Uses a random\n   seed to generate elements to sort.\n\nUSAGE\n   %s [-habBcesSPlqtQwdgvW] [-n length] [-p elements] [-r "
+	    "seed] [-i file] [-o format] [-j threads] [-F profile] [-T records] [-k keys] [-G pattern]\n   %s -C [-H] [-habBcesSPlqtQwdgv] [-n lengths] [-p elements] [-r seeds] [-G pattern] [-i file] [-o format]\n   %s -I batch [-n length] [-p elements] [-r seed] [-i file] [-o format] [-j threads] [-v]\n   %s -uU [-n length] [-p elements] [-r seed] [-k keys] [-G pattern] [-i file] [-o format] [-v] [-W]\n   %s -A [-n length] [-r seed] [-i file] [-F profile]\n\nOPTIONS\n   -h              Prints the help text.\n   -a              Enables all sorts.\n   -b              Enables bubble sort.\n   -B              Enables bubble sort (last swap tracking).\n   -c              Enables cocktail shaker sort.\n   -e              Enables odd-even transposition sort.\n   -s              Enables shell sort (Ciura gap "
+	    "sequence).\n   -S              Enables shell sort (Pratt gap sequence).\n   -P              Enables cache-aware shell sort (Pratt gap sequence).\n   -l              Enables shell sort (gap sequence from the tuning profile).\n   -q              Enables quicksort (recursive).\n   -t              Enables quicksort (stack).\n   -Q              "
+	    "Enables quicksort (queue).\n   -w              Enables multi-threaded quicksort (concurrent queue).\n   -d              Enables multi-threaded quicksort (work-stealing deques).\n   -g              Enables argsort (packed key-index words) with a gather of the\n                   sorted rows.\n   -I batch        Appends the elements to a sorted array batch elements at a\n                   time, merging each batch in, and prints the amortized cost\n                   per inserted element (not included in -a).\n   -u              Enables quicksort that removes duplicates as it sorts (not\n                   included in -a).\n   -U              Enables quicksort that counts each key as it sorts (not\n                   included in -a).\n   -C              Runs every sort of every length and seed as its own job, with\n                   the jobs running concurrently, each pinned to its own CPU, and\n                   prints the results in order. Multi-threaded sorts use one\n                   thread. -n and -r take comma-separated lists.\n   -H              Leaves all but one hyperthread of each core idle (with -C).\n   -W              Runs the sorts through their size_t-length entry points, which\n                   split arrays too long for 32-bit indices before sorting them.\n   -n length       Number of array elements to generate.\n   -p elements     Number of total elements to print.\n   -r seed         Random seed used to generate "
+	    "array elements.\n   -k keys         Limits generated elements to keys distinct values, so that\n                   they repeat.\n   -G pattern      Pattern of generated elements: random (default) or organ_pipe\n                   (rising from 0 to half the length, then falling back to 1).\n   -i file         Reads the elements to sort from a file of whitespace-separated\n                   numbers instead of "
+	    "generating them.\n   -o format       Format of printed elements: table (five per row, default) or\n                   lines (one per line).\n   -j threads      Number of threads for parallel sorts (defaults to the\n                   tuning profile's).\n   -v              Verifies that each sort's output is a sorted permutation of\n                   the input.\n   -T records      Traces the partitions of the recursive, stack and queue\n                   quicksorts, keeping the last records partitions, and prints a\n                   report of them.\n   -A              Benchmarks sort settings on this machine and saves the fastest\n                   to the tuning profile instead of sorting.\n   -F profile      Tuning profile to load (or to save with -A). Defaults to\n                   $" TUNING_PROFILE_ENV ", or " DEFAULT_PROFILE_PATH " when saving.\n",
+	    program_path, program_path, program_path, program_path, program_path );
 }
 
 // Description:
@@ -61,34 +180,327 @@ static void print_help( char *program_path ) {
 // char *sort_name - The name of the sort used.
 // SortingStatistics stats - Sorting statistics to print.
 // uint32_t *sorted_array - The sorted array.
-// uint32_t max_to_print - The max number of elements to print.
+// RunConfig *config - A pointer to the settings for printing.
 //
 // Returns:
-// Nothing.
-static void print_sort( char *sort_name, SortingStatistics stats, uint32_t *sorted_array, uint32_t max_to_print ) {
-	printf( "%s\n%" PRIu32 " elements, %" PRIu64 " moves, %" PRIu64 " compares\n", sort_name, stats.elements, stats.moves, stats.compares );
+// bool - Whether the operation was successful.
+static bool print_sort( char *sort_name, SortingStatistics stats, uint32_t *sorted_array, RunConfig *config ) {
+	uint32_t max_to_print = config->max_to_print;
+	FastWriter *out = config->out;
+
+	printf( "%s\n%" PRIu64 " elements, %" PRIu64 " moves, %" PRIu64 " compares\n", sort_name, stats.elements, stats.moves, stats.compares );
 
 	if ( stats.max_ds_size > 0 ) {
-		printf( "Max data structure size: %" PRIu32 "\n", stats.max_ds_size );
+		printf( "Max data structure size: %" PRIu64 "\n", stats.max_ds_size );
 	}
 
+	fflush( stdout ); // The sorted elements bypass stdio, so everything before them has to be written first.
+	bool ok = true;
+
 	// Print sorted array.
-	for ( uint32_t i = 0; i < max_to_print; i++ ) {
-		printf( "   %10" PRIu32, sorted_array[ i ] );
+	if ( config->format == FORMAT_LINES ) {
+		for ( uint32_t i = 0; i < max_to_print && ok; i++ ) {
+			ok = fast_writer_u32( out, sorted_array[ i ] ) && fast_writer_bytes( out, "\n", 1 );
+		}
+	} else {
+		for ( uint32_t i = 0; i < max_to_print && ok; i++ ) {
+			ok = fast_writer_u32_padded( out, sorted_array[ i ] );
+
+			// Print a new line if the array index + 1 is a multiple of 5 (five elements per row max).
+			if ( ( i + 1 ) % 5 == 0 ) {
+				ok = ok && fast_writer_bytes( out, "\n", 1 );
+			}
+		}
+
+		// Print a new line because the last row did not have five elements to print.
+		if ( max_to_print % 5 != 0 ) {
+			ok = ok && fast_writer_bytes( out, "\n", 1 );
+		}
+	}
+
+	return fast_writer_flush( out ) && ok;
+}
+
+// Description:
+// Gets the time from a monotonic clock.
+//
+// Parameters:
+// Nothing.
+//
+// Returns:
+// double - The time in seconds.
+static double now( ) {
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( double ) ts.tv_sec + ( double ) ts.tv_nsec / 1e9;
+}
+
+// Description:
+// Checks that a sort's output is sorted and is a permutation of the input, and prints the result.
+//
+// Parameters:
+// uint32_t *sorted_array - The sorted array.
+// uint32_t len - The number of elements.
+// RunConfig *config - A pointer to the settings holding the input's multiset hash.
+//
+// Returns:
+// bool - Whether the output passed verification.
+static bool verify_sort( uint32_t *sorted_array, uint32_t len, RunConfig *config ) {
+	double start = now( );
+	bool sorted = verify_sorted( sorted_array, len, config->threads );
+	bool permutation = verify_same_multiset( verify_multiset_hash( sorted_array, len, config->threads ), config->input_hash );
+	double elapsed = now( ) - start;
+
+	if ( sorted && permutation ) {
+		printf( "Verified: sorted permutation of the input (%.6f s)\n", elapsed );
+	} else {
+		printf( "Verification failed:%s%s\n", sorted ? "" : " not sorted", permutation ? "" : " not a permutation of the input" );
+	}
+
+	return sorted && permutation;
+}
+
+// Description:
+// Sorts an array the way wide rows are sorted: argsorts the keys, then gathers the rows (here just
+// the keys themselves) into sorted order. Falls back to quicksort if the buffers cannot be allocated.
+//
+// Parameters:
+// uint32_t *arr - The array to sort.
+// uint32_t len - The length of the array to sort.
+//
+// Returns:
+// SortingStatistics - The statistics for the sort (moves and compares are of the packed words).
+static SortingStatistics argsort_and_gather( uint32_t *arr, uint32_t len ) {
+	uint32_t *perm = ( uint32_t * ) calloc( len, sizeof( uint32_t ) );
+	uint32_t *rows = ( uint32_t * ) calloc( len, sizeof( uint32_t ) );
+	SortingStatistics stats;
+
+	if ( !perm || !rows || !argsort( arr, len, perm, &stats ) ) {
+		free( perm );
+		free( rows );
+
+		return quicksort_recursive( arr, len );
+	}
+
+	memcpy( rows, arr, len * sizeof( uint32_t ) );
+	argsort_gather( rows, sizeof( uint32_t ), perm, len, arr );
+	free( perm );
+	free( rows );
+
+	return stats;
+}
+
+// Description:
+// Sorts a copy of the input array and prints the sort's data.
+//
+// Parameters:
+// char *sort_name - The name of the sort used.
+// SortingStatistics ( *sort_function )( uint32_t *, uint32_t ) - The sort to run.
+// uint32_t *input - The unsorted elements.
+// uint32_t len - The number of elements.
+// RunConfig *config - A pointer to the settings for printing and verifying.
+//
+// Returns:
+// bool - Whether the operation was successful.
+static bool run_and_print_sort( char *sort_name, SortingStatistics ( *sort_function )( uint32_t *, uint32_t ), uint32_t *input, uint32_t len, RunConfig *config ) {
+	uint32_t *arr = ( uint32_t * ) huge_alloc( len * sizeof( uint32_t ) );
+
+	if ( !arr ) {
+		fprintf( stderr, "Failed to allocate array to sort.\n" );
+
+		return false;
+	}
+
+	memcpy( arr, input, len * sizeof( uint32_t ) );
+
+	if ( config->trace ) {
+		partition_trace_clear( config->trace );
+	}
+
+	SortingStatistics stats = config->large ? sort_large( arr, len, sort_function ) : sort_function( arr, len );
+	bool printed = print_sort( sort_name, stats, arr, config );
+	bool verified = !config->verify || verify_sort( arr, len, config );
+
+	if ( config->trace && partition_trace_count( config->trace ) > 0 ) { // Only the traced quicksorts record partitions.
+		partition_trace_report( config->trace, stdout );
+	}
+
+	huge_free( arr, len * sizeof( uint32_t ) );
+	arr = NULL;
+
+	if ( !printed ) {
+		fprintf( stderr, "Failed to print sorted array.\n" );
+	}
+
+	return printed && verified;
+}
 
-		// Print a new line if the array index + 1 is a multiple of 5 (five elements per row max).
-		if ( ( i + 1 ) % 5 == 0 ) {
-			printf( "\n" );
+// Description:
+// Orders keys for qsort( ).
+//
+// Parameters:
+// const void *a - A pointer to the first key.
+// const void *b - A pointer to the second key.
+//
+// Returns:
+// int - Negative, zero or positive if a comes before, with or after b.
+static int compare_keys( const void *a, const void *b ) {
+	uint32_t x = *( const uint32_t * ) a;
+	uint32_t y = *( const uint32_t * ) b;
+
+	return x == y ? 0 : ( x < y ? -1 : 1 );
+}
+
+// Description:
+// Checks the output of a fused sort against sorting a copy of the input with qsort( ) and then deduplicating
+// or counting it in a separate pass, and prints the result. qsort( ) shares no code with the quicksorts, so
+// inputs that are slow for them do not slow down the check.
+//
+// Parameters:
+// uint32_t *input - The unsorted elements.
+// uint32_t len - The number of elements.
+// const uint32_t *keys - The unique keys (NULL if counts were output).
+// const KeyCount *counts - The (key, count) pairs (NULL if unique keys were output).
+// uint32_t out_len - The number of keys or pairs output.
+//
+// Returns:
+// bool - Whether the output passed verification (false if the copy could not be allocated).
+static bool verify_fused_dedup( uint32_t *input, uint32_t len, const uint32_t *keys, const KeyCount *counts, uint32_t out_len ) {
+	double start = now( );
+	uint32_t *sorted = ( uint32_t * ) calloc( len, sizeof( uint32_t ) );
+
+	if ( !sorted ) {
+		fprintf( stderr, "Failed to allocate array to verify.\n" );
+
+		return false;
+	}
+
+	memcpy( sorted, input, len * sizeof( uint32_t ) );
+	qsort( sorted, len, sizeof( uint32_t ), compare_keys );
+	uint32_t runs = 0;
+	bool matches = true;
+
+	for ( uint32_t i = 0; i < len && matches; runs++ ) {
+		uint32_t run = i + 1;
+
+		while ( run < len && sorted[ run ] == sorted[ i ] ) {
+			run++;
 		}
+
+		if ( runs >= out_len ) {
+			matches = false;
+		} else if ( keys ) {
+			matches = keys[ runs ] == sorted[ i ];
+		} else {
+			matches = counts[ runs ].key == sorted[ i ] && counts[ runs ].count == run - i;
+		}
+
+		i = run;
 	}
 
-	// Print a new line because the last row did not have five elements to print.
-	if ( max_to_print % 5 != 0 ) {
-		printf( "\n" );
+	matches = matches && runs == out_len;
+	free( sorted );
+
+	if ( matches ) {
+		printf( "Verified: matches sorting and then deduplicating separately (%.6f s)\n", now( ) - start );
+	} else {
+		printf( "Verification failed: does not match sorting and then deduplicating separately\n" );
 	}
+
+	return matches;
 }
 
-static bool run_and_print_sort( char *sort_name, SortingStatistics ( *sort_function )( uint32_t *, uint32_t ), uint32_t len, uint32_t random_seed, uint32_t max_to_print ) {
+// Description:
+// Sorts a copy of the input with a sort that removes duplicates or counts keys as it sorts, then prints the
+// output, its length and how many bytes it saves over the sorted array.
+//
+// Parameters:
+// char *sort_name - The name of the sort used.
+// uint32_t *input - The unsorted elements.
+// uint32_t len - The number of elements.
+// bool count_keys - Whether to output (key, count) pairs instead of unique keys.
+// RunConfig *config - A pointer to the settings for printing and verifying.
+//
+// Returns:
+// bool - Whether the operation was successful.
+static bool run_fused_dedup( char *sort_name, uint32_t *input, uint32_t len, bool count_keys, RunConfig *config ) {
+	uint32_t *arr = ( uint32_t * ) calloc( len, sizeof( uint32_t ) );
+	KeyCount *counts = count_keys ? ( KeyCount * ) calloc( len, sizeof( KeyCount ) ) : NULL;
+
+	if ( !arr || ( count_keys && !counts ) ) {
+		fprintf( stderr, "Failed to allocate array to sort.\n" );
+		free( arr );
+		free( counts );
+
+		return false;
+	}
+
+	memcpy( arr, input, len * sizeof( uint32_t ) );
+	uint32_t out_len = 0;
+	SortingStatistics stats;
+
+	if ( config->large ) {
+		size_t large_len = 0;
+		stats = count_keys ? quicksort_counts_large( arr, len, counts, &large_len ) : quicksort_unique_large( arr, len, &large_len );
+		out_len = ( uint32_t ) large_len; // No longer than the input.
+	} else {
+		stats = count_keys ? quicksort_counts( arr, len, counts, &out_len ) : quicksort_unique( arr, len, &out_len );
+	}
+
+	RunConfig out_config = *config;
+	out_config.max_to_print = config->max_to_print < out_len ? config->max_to_print : out_len;
+	bool printed = true;
+
+	if ( count_keys ) { // Print each pair on its own line.
+		printf( "%s\n%" PRIu64 " elements, %" PRIu64 " moves, %" PRIu64 " compares\n", sort_name, stats.elements, stats.moves, stats.compares );
+		fflush( stdout );
+
+		for ( uint32_t i = 0; i < out_config.max_to_print && printed; i++ ) {
+			printed = fast_writer_u32_padded( config->out, counts[ i ].key ) && fast_writer_bytes( config->out, " x ", 3 ) && fast_writer_u32( config->out, counts[ i ].count ) &&
+			    fast_writer_bytes( config->out, "\n", 1 );
+		}
+
+		printed = fast_writer_flush( config->out ) && printed;
+	} else {
+		printed = print_sort( sort_name, stats, arr, &out_config );
+	}
+
+	// Pairs take twice the space of keys, so with few duplicates the counts can outgrow the sorted array.
+	uint64_t in_bytes = ( uint64_t ) len * sizeof( uint32_t );
+	uint64_t out_bytes = ( uint64_t ) out_len * ( count_keys ? sizeof( KeyCount ) : sizeof( uint32_t ) );
+	printf( "Output: %" PRIu32 " %s, %" PRIu64 " bytes (%" PRIu64 " bytes %s)\n", out_len, count_keys ? "(key, count) pairs" : "unique keys", out_bytes,
+	    out_bytes > in_bytes ? out_bytes - in_bytes : in_bytes - out_bytes, out_bytes > in_bytes ? "more" : "saved" );
+	bool verified = !config->verify || verify_fused_dedup( input, len, count_keys ? NULL : arr, counts, out_len );
+	free( arr );
+	free( counts );
+
+	if ( !printed ) {
+		fprintf( stderr, "Failed to print sorted array.\n" );
+	}
+
+	return printed && verified;
+}
+
+// Description:
+// Simulates appending the input to a sorted array in batches, merging each batch in as it arrives, and
+// prints the amortized cost per inserted element next to the cost of quicksorting everything at once.
+//
+// Parameters:
+// uint32_t *input - The elements to append, in arrival order.
+// uint32_t len - The number of elements.
+// uint32_t batch_size - The number of elements appended at a time.
+// RunConfig *config - A pointer to the settings for printing and verifying.
+//
+// Returns:
+// bool - Whether the operation was successful.
+static bool run_incremental_merge( uint32_t *input, uint32_t len, uint32_t batch_size, RunConfig *config ) {
+	if ( batch_size == 0 ) {
+		fprintf( stderr, "Invalid batch size.\n" );
+
+		return false;
+	}
+
 	uint32_t *arr = ( uint32_t * ) calloc( len, sizeof( uint32_t ) );
 
 	if ( !arr ) {
@@ -97,15 +509,259 @@ static bool run_and_print_sort( char *sort_name, SortingStatistics ( *sort_funct
 		return false;
 	}
 
-	generate_random_array( arr, random_seed, len );
-	SortingStatistics stats = sort_function( arr, len );
-	print_sort( sort_name, stats, arr, max_to_print );
+	memcpy( arr, input, len * sizeof( uint32_t ) );
+	SortingStatistics stats = sorting_statistics_create( len );
+	uint32_t batches = 0;
+	double last_batch_time = 0;
+	uint32_t last_batch_len = 0;
+	double start = now( );
+
+	for ( uint32_t sorted = 0; sorted < len; sorted += last_batch_len ) {
+		last_batch_len = len - sorted < batch_size ? len - sorted : batch_size;
+		double batch_start = now( );
+		SortingStatistics batch_stats = merge_batch( arr, sorted, sorted + last_batch_len );
+		last_batch_time = now( ) - batch_start;
+		stats.moves += batch_stats.moves;
+		stats.compares += batch_stats.compares;
+		batches++;
+	}
+
+	double elapsed = now( ) - start;
+	char sort_name[ 64 ];
+	snprintf( sort_name, sizeof( sort_name ), "Incremental Merge (Batches of %" PRIu32 ")", batch_size );
+	bool printed = print_sort( sort_name, stats, arr, config );
+	bool verified = !config->verify || verify_sort( arr, len, config );
+
+	// Quicksort everything at once for comparison.
+	memcpy( arr, input, len * sizeof( uint32_t ) );
+	double quicksort_start = now( );
+	quicksort_recursive( arr, len );
+	double quicksort_time = now( ) - quicksort_start;
+	printf( "%" PRIu32 " batches: %.1f ns per inserted element (last batch %.1f ns), quicksort of all elements %.1f ns per element\n", batches, elapsed * 1e9 / len,
+	    last_batch_time * 1e9 / last_batch_len, quicksort_time * 1e9 / len );
 	free( arr );
 	arr = NULL;
 
+	if ( !printed ) {
+		fprintf( stderr, "Failed to print sorted array.\n" );
+	}
+
+	return printed && verified;
+}
+
+// Description:
+// Autotunes the sorts and saves the winning settings to a tuning profile.
+//
+// Parameters:
+// uint32_t *input - The unsorted elements to benchmark with.
+// uint32_t len - The number of elements.
+// char *profile_path - The path to save the profile to, or NULL for the default path.
+//
+// Returns:
+// bool - Whether the operation was successful.
+static bool run_autotune( uint32_t *input, uint32_t len, char *profile_path ) {
+	TuningProfile best;
+
+	if ( !autotune( input, len, &best ) ) {
+		fprintf( stderr, "Failed to allocate array to sort.\n" );
+
+		return false;
+	}
+
+	if ( !profile_path ) {
+		profile_path = getenv( TUNING_PROFILE_ENV ) ? getenv( TUNING_PROFILE_ENV ) : DEFAULT_PROFILE_PATH;
+	}
+
+	if ( !tuning_save( profile_path, &best ) ) {
+		fprintf( stderr, "Failed to save tuning profile to %s.\n", profile_path );
+
+		return false;
+	}
+
+	printf( "Saved tuning profile to %s\n", profile_path );
+
 	return true;
 }
 
+// The sorts the program can run, in the order they run.
+static const SortEntry sorts[] = {
+	{ F_BUBBLE, "Bubble Sort", bubble_sort, true },
+	{ F_BUBBLE_LAST_SWAP, "Bubble Sort (Last Swap Tracking)", bubble_sort_last_swap, true },
+	{ F_COCKTAIL, "Cocktail Shaker Sort", cocktail_sort, true },
+	{ F_ODD_EVEN, "Odd-Even Transposition Sort", odd_even_sort, true },
+	{ F_SHELL_CIURA, "Shell Sort (Ciura Gap Sequence)", shell_sort_ciura, false },
+	{ F_SHELL_PRATT, "Shell Sort (Pratt Gap Sequence)", shell_sort_pratt, false },
+	{ F_SHELL_PRATT_CACHE, "Shell Sort (Pratt Gap Sequence, Cache-Aware)", shell_sort_cache_aware_pratt, false },
+	{ F_SHELL_TUNED, "Shell Sort (Tuned Gap Sequence)", shell_sort_tuned, false },
+	{ F_QUICK_RECURSIVE, "Quicksort (Recursive)", quicksort_recursive, false },
+	{ F_QUICK_STACK, "Quicksort (Stack)", quicksort_stack, false },
+	{ F_QUICK_QUEUE, "Quicksort (Queue)", quicksort_queue, false },
+	{ F_QUICK_CONCURRENT_QUEUE, "Quicksort (Concurrent Queue)", quicksort_concurrent_queue, false },
+	{ F_QUICK_WORK_STEALING, "Quicksort (Work-Stealing Deques)", quicksort_work_stealing, false },
+	{ F_ARGSORT, "Argsort (Packed Words, Gather)", argsort_and_gather, false },
+};
+
+#define SORT_COUNT ( sizeof( sorts ) / sizeof( sorts[ 0 ] ) ) // The number of sorts in sorts.
+
+// Description:
+// Parses a comma-separated list of numbers.
+//
+// Parameters:
+// char *str - The list. It is modified while being parsed.
+// uint32_t *values - Set to the numbers.
+// uint32_t max - The most numbers the list may have.
+//
+// Returns:
+// uint32_t - The number of numbers, or 0 if the list has more than max.
+static uint32_t parse_list( char *str, uint32_t *values, uint32_t max ) {
+	uint32_t count = 0;
+
+	for ( char *token = strtok( str, "," ); token; token = strtok( NULL, "," ) ) {
+		if ( count == max ) {
+			return 0;
+		}
+
+		values[ count++ ] = strtoul( token, NULL, 10 );
+	}
+
+	return count;
+}
+
+// Description:
+// Runs one scheduled sort. The job fills its own array on the CPU it runs on, which faults in every page
+// before the sort is timed.
+//
+// Parameters:
+// void *arg - A pointer to the SortJob.
+//
+// Returns:
+// Nothing.
+static void run_sort_job( void *arg ) {
+	SortJob *job = ( SortJob * ) arg;
+	uint32_t *arr = ( uint32_t * ) calloc( job->len, sizeof( uint32_t ) );
+	job->head = ( uint32_t * ) calloc( job->head_len > 0 ? job->head_len : 1, sizeof( uint32_t ) );
+
+	if ( !arr || !job->head ) {
+		free( arr );
+
+		return;
+	}
+
+	if ( job->input ) {
+		memcpy( arr, job->input, job->len * sizeof( uint32_t ) );
+	} else {
+		generate_array( arr, job->seed, job->len, job->key_range, job->pattern );
+	}
+
+	MultisetHash input_hash = job->verify ? verify_multiset_hash( arr, job->len, 1 ) : ( MultisetHash ) { 0, 0 };
+	double start = now( );
+	job->stats = job->sort->sort_function( arr, job->len );
+	job->elapsed = now( ) - start;
+	job->verified = !job->verify || ( verify_sorted( arr, job->len, 1 ) && verify_same_multiset( verify_multiset_hash( arr, job->len, 1 ), input_hash ) );
+	memcpy( job->head, arr, job->head_len * sizeof( uint32_t ) );
+	job->ran = true;
+	free( arr );
+}
+
+// Description:
+// Runs every enabled sort of every length and seed as a concurrent job pinned to its own CPU, then prints
+// the results in the order the sorts run sequentially, by length, then seed.
+//
+// Parameters:
+// Set args - The enabled sorts.
+// uint32_t *lengths - The array lengths.
+// uint32_t length_count - The number of array lengths.
+// uint32_t *seeds - The seeds.
+// uint32_t seed_count - The number of seeds.
+// uint32_t *input - The elements to sort, or NULL to generate them.
+// bool skip_siblings - Whether to leave all but one hyperthread of each core idle.
+// RunConfig *config - A pointer to the settings for printing and verifying.
+//
+// Returns:
+// bool - Whether the operation was successful.
+static bool run_scheduled( Set args, uint32_t *lengths, uint32_t length_count, uint32_t *seeds, uint32_t seed_count, uint32_t *input, bool skip_siblings, RunConfig *config ) {
+	SortJob *sort_jobs = ( SortJob * ) calloc( length_count * seed_count * SORT_COUNT, sizeof( SortJob ) );
+	SchedulerJob *jobs = ( SchedulerJob * ) calloc( length_count * seed_count * SORT_COUNT, sizeof( SchedulerJob ) );
+	uint32_t count = 0;
+
+	if ( !sort_jobs || !jobs ) {
+		fprintf( stderr, "Failed to allocate jobs.\n" );
+		free( sort_jobs );
+		free( jobs );
+
+		return false;
+	}
+
+	for ( uint32_t l = 0; l < length_count; l++ ) {
+		for ( uint32_t r = 0; r < seed_count; r++ ) {
+			for ( uint32_t i = 0; i < SORT_COUNT; i++ ) {
+				if ( !set_member( args, sorts[ i ].flag ) && !set_member( args, F_ALL ) ) {
+					continue;
+				}
+
+				double len = lengths[ l ];
+				double log_len = 32 - __builtin_clz( lengths[ l ] ); // Bits in the length, a cheap log2.
+				sort_jobs[ count ] = ( SortJob ) { .sort = &sorts[ i ], .len = lengths[ l ], .seed = seeds[ r ], .key_range = config->key_range, .pattern = config->pattern, .input = input, .verify = config->verify };
+				sort_jobs[ count ].head_len = config->max_to_print < lengths[ l ] ? config->max_to_print : lengths[ l ];
+				jobs[ count ] = ( SchedulerJob ) { .run = run_sort_job, .arg = &sort_jobs[ count ], .cost = sorts[ i ].quadratic ? len * len : len * log_len };
+				count++;
+			}
+		}
+	}
+
+	// Each job gets one CPU, so the multi-threaded sorts run single-threaded.
+	bubble_set_thread_count( 1 );
+	quick_set_thread_count( 1 );
+	argsort_set_thread_count( 1 );
+	bool ok = scheduler_run( jobs, count, skip_siblings );
+
+	if ( !ok ) {
+		fprintf( stderr, "Failed to start the scheduler.\n" );
+	}
+
+	for ( uint32_t j = 0; ok && j < count; j++ ) {
+		SortJob *job = &sort_jobs[ j ];
+		char sort_name[ 128 ];
+
+		if ( !job->ran ) {
+			fprintf( stderr, "Failed to allocate array to sort.\n" );
+			ok = false;
+
+			break;
+		}
+
+		if ( input ) {
+			snprintf( sort_name, sizeof( sort_name ), "%s (n=%" PRIu32 ")", job->sort->name, job->len );
+		} else {
+			snprintf( sort_name, sizeof( sort_name ), "%s (n=%" PRIu32 ", seed=%" PRIu32 ")", job->sort->name, job->len, job->seed );
+		}
+
+		RunConfig job_config = *config;
+		job_config.max_to_print = job->head_len;
+
+		if ( !print_sort( sort_name, job->stats, job->head, &job_config ) ) {
+			fprintf( stderr, "Failed to print sorted array.\n" );
+			ok = false;
+		}
+
+		if ( job->verify ) {
+			printf( job->verified ? "Verified: sorted permutation of the input\n" : "Verification failed\n" );
+			ok = ok && job->verified;
+		}
+
+		printf( "Time: %.6f s\n", job->elapsed );
+	}
+
+	for ( uint32_t j = 0; j < count; j++ ) {
+		free( sort_jobs[ j ].head );
+	}
+
+	free( sort_jobs );
+	free( jobs );
+
+	return ok;
+}
+
 // Description:
 // The entry point of the program.
 //
@@ -118,88 +774,241 @@ static bool run_and_print_sort( char *sort_name, SortingStatistics ( *sort_funct
 int main( int argc, char **argv ) {
 	int32_t opt = 0;
 	Set args = set_empty( );
-	uint32_t array_length = DEFAULT_ARRAY_LENGTH;
+	uint32_t lengths[ MAX_LIST_LENGTH ] = { DEFAULT_ARRAY_LENGTH };
+	uint32_t length_count = 1;
 	uint32_t max_to_print = DEFAULT_MAX_TO_PRINT;
-	uint32_t random_seed = DEFAULT_RANDOM_SEED;
+	uint32_t seeds[ MAX_LIST_LENGTH ] = { DEFAULT_RANDOM_SEED };
+	uint32_t seed_count = 1;
+	uint32_t threads = 0; // 0 uses the tuning profile's thread count.
+	char *input_path = NULL;
+	char *profile_path = NULL;
+	bool autotune_mode = false;
+	bool verify = false;
+	uint32_t trace_records = 0;
+	uint32_t batch_size = 0;
+	uint32_t key_range = 0; // 0 generates keys from the full range.
+	bool length_set = false;
+	bool schedule_mode = false;
+	bool skip_siblings = false;
+	bool large = false;
+	output_format format = FORMAT_TABLE;
+	input_pattern pattern = PATTERN_RANDOM;
 
 	while ( ( opt = getopt( argc, argv, OPTIONS ) ) != -1 ) { // Process each option specified.
 		switch ( opt ) {
 		case 'h': print_help( *argv ); return 0; // Print help.
 		case 'a': args = set_insert( args, F_ALL ); break; // All sorts.
 		case 'b': args = set_insert( args, F_BUBBLE ); break; // Bubble sort.
+		case 'B': args = set_insert( args, F_BUBBLE_LAST_SWAP ); break; // Bubble sort (last swap tracking).
+		case 'c': args = set_insert( args, F_COCKTAIL ); break; // Cocktail shaker sort.
+		case 'e': args = set_insert( args, F_ODD_EVEN ); break; // Odd-even transposition sort.
 		case 's': args = set_insert( args, F_SHELL_CIURA ); break; // Shell sort (Ciura gap sequence).
 		case 'S': args = set_insert( args, F_SHELL_PRATT ); break; // Shell sort (Pratt gap sequence).
+		case 'P': args = set_insert( args, F_SHELL_PRATT_CACHE ); break; // Cache-aware shell sort (Pratt gap sequence).
+		case 'l': args = set_insert( args, F_SHELL_TUNED ); break; // Shell sort (tuned gap sequence).
 		case 'q': args = set_insert( args, F_QUICK_RECURSIVE ); break; // Quicksort (recursive).
 		case 't': args = set_insert( args, F_QUICK_STACK ); break; // Quicksort (stack).
 		case 'Q': args = set_insert( args, F_QUICK_QUEUE ); break; // Quicksort (queue).
-		case 'n': array_length = strtoul( optarg, NULL, 10 ); break; // Array length.
+		case 'w': args = set_insert( args, F_QUICK_CONCURRENT_QUEUE ); break; // Multi-threaded quicksort (concurrent queue).
+		case 'd': args = set_insert( args, F_QUICK_WORK_STEALING ); break; // Multi-threaded quicksort (work-stealing deques).
+		case 'g': args = set_insert( args, F_ARGSORT ); break; // Argsort with a gather.
+		case 'I': // Incremental merge.
+			args = set_insert( args, F_INCREMENTAL_MERGE );
+			batch_size = strtoul( optarg, NULL, 10 );
+
+			break;
+		case 'v': verify = true; break; // Verify.
+		case 'u': args = set_insert( args, F_UNIQUE ); break; // Quicksort with duplicate removal.
+		case 'U': args = set_insert( args, F_COUNTS ); break; // Quicksort with key counts.
+		case 'k': key_range = strtoul( optarg, NULL, 10 ); break; // Distinct generated keys.
+		case 'C': schedule_mode = true; break; // Run the sorts as concurrent pinned jobs.
+		case 'H': skip_siblings = true; break; // Leave sibling hyperthreads idle.
+		case 'W': large = true; break; // Use the size_t-length entry points.
+		case 'T': trace_records = strtoul( optarg, NULL, 10 ); break; // Partition trace size.
+		case 'A': autotune_mode = true; break; // Autotune.
+		case 'F': profile_path = optarg; break; // Tuning profile.
+		case 'n': // Array lengths.
+			length_count = parse_list( optarg, lengths, MAX_LIST_LENGTH );
+			length_set = true;
+
+			break;
 		case 'p': max_to_print = strtoul( optarg, NULL, 10 ); break; // Max elements to print.
-		case 'r': random_seed = strtoul( optarg, NULL, 10 ); break; // Random seed.
+		case 'r': seed_count = parse_list( optarg, seeds, MAX_LIST_LENGTH ); break; // Random seeds.
+		case 'j': threads = strtoul( optarg, NULL, 10 ); break; // Threads for parallel sorts.
+		case 'i': input_path = optarg; break; // Input file.
+		case 'G': // Pattern of generated elements.
+			if ( strcmp( optarg, "random" ) == 0 ) {
+				pattern = PATTERN_RANDOM;
+			} else if ( strcmp( optarg, "organ_pipe" ) == 0 ) {
+				pattern = PATTERN_ORGAN_PIPE;
+			} else {
+				fprintf( stderr, "Invalid pattern.\n" );
+
+				return 1;
+			}
+
+			break;
+		case 'o': // Output format.
+			if ( strcmp( optarg, "table" ) == 0 ) {
+				format = FORMAT_TABLE;
+			} else if ( strcmp( optarg, "lines" ) == 0 ) {
+				format = FORMAT_LINES;
+			} else {
+				fprintf( stderr, "Invalid output format.\n" );
+
+				return 1;
+			}
+
+			break;
 		default: print_help( *argv ); return 1; // Invalid flag.
 		}
 	}
 
-	if ( args == set_empty( ) ) { // No sorts entered.
+	if ( profile_path && !autotune_mode ) { // Make the sorts load this profile instead of the one from the environment.
+		setenv( TUNING_PROFILE_ENV, profile_path, 1 );
+	}
+
+	if ( !autotune_mode && args == set_empty( ) ) { // No sorts entered.
 		fprintf( stderr, "Select at least one sort to perform.\n" );
 		print_help( *argv );
 
 		return 1;
 	}
 
-	if ( array_length == 0 ) { //
-		fprintf( stderr, "Invalid array length.\n" );
+	if ( length_count == 0 || seed_count == 0 ) {
+		fprintf( stderr, "At most %d array lengths and seeds can be given.\n", MAX_LIST_LENGTH );
 
 		return 1;
 	}
 
-	// Set max_to_print to the number of elements to print.
-	max_to_print = max_to_print < array_length ? max_to_print : array_length;
+	if ( !schedule_mode && ( length_count > 1 || seed_count > 1 ) ) {
+		fprintf( stderr, "Multiple array lengths or seeds need -C.\n" );
 
-	// Bubble sort.
-	if ( set_member( args, F_BUBBLE ) || set_member( args, F_ALL ) ) {
-		if ( !run_and_print_sort( "Bubble Sort", bubble_sort, array_length, random_seed, max_to_print ) ) {
-			return 1;
-		}
+		return 1;
+	}
+
+	if ( schedule_mode && ( autotune_mode || trace_records > 0 || large || set_member( args, F_INCREMENTAL_MERGE ) || set_member( args, F_UNIQUE ) || set_member( args, F_COUNTS ) ) ) {
+		fprintf( stderr, "-C cannot be combined with -A, -T, -W, -I, -u or -U.\n" );
+
+		return 1;
 	}
 
-	// Shell sort (Ciura gap sequence).
-	if ( set_member( args, F_SHELL_CIURA ) || set_member( args, F_ALL ) ) {
-		shell_set_gap_sequence( ciura_gap_seq, CIURA_GAP_SEQ_SIZE );
+	for ( uint32_t l = 0; l < length_count && !input_path; l++ ) {
+		if ( lengths[ l ] == 0 ) {
+			fprintf( stderr, "Invalid array length.\n" );
 
-		if ( !run_and_print_sort( "Shell Sort (Ciura Gap Sequence)", shell_sort, array_length, random_seed, max_to_print ) ) {
 			return 1;
 		}
 	}
 
-	// Shell sort (Pratt gap sequence).
-	if ( set_member( args, F_SHELL_PRATT ) || set_member( args, F_ALL ) ) {
-		shell_set_gap_sequence( pratt_gap_seq, PRATT_GAP_SEQ_SIZE );
+	uint32_t *input = NULL;
+	uint32_t array_length = autotune_mode && !length_set ? AUTOTUNE_LENGTH : lengths[ 0 ];
+	uint32_t random_seed = seeds[ 0 ];
+
+	if ( input_path ) { // Read the elements to sort from a file.
+		input = fast_io_read_keys( input_path, &array_length );
+
+		if ( !input ) {
+			fprintf( stderr, "Failed to read elements from %s.\n", input_path );
 
-		if ( !run_and_print_sort( "Shell Sort (Pratt Gap Sequence)", shell_sort, array_length, random_seed, max_to_print ) ) {
 			return 1;
 		}
-	}
+	} else if ( !schedule_mode ) { // Generate the elements to sort (scheduled jobs generate their own).
+		input = ( uint32_t * ) calloc( array_length, sizeof( uint32_t ) );
+
+		if ( !input ) {
+			fprintf( stderr, "Failed to allocate array to sort.\n" );
 
-	// Quicksort (recursive).
-	if ( set_member( args, F_QUICK_RECURSIVE ) || set_member( args, F_ALL ) ) {
-		if ( !run_and_print_sort( "Quicksort (Recursive)", quicksort_recursive, array_length, random_seed, max_to_print ) ) {
 			return 1;
 		}
+
+		generate_array( input, random_seed, array_length, key_range, pattern );
+	}
+
+	if ( autotune_mode ) {
+		bool tuned = run_autotune( input, array_length, profile_path );
+		free( input );
+		input = NULL;
+
+		return tuned ? 0 : 1;
+	}
+
+	threads = threads > 0 ? threads : tuning_get( )->threads;
+	FastWriter *out = fast_writer_create( STDOUT_FILENO, OUTPUT_BUFFER_SIZE );
+
+	if ( !out ) {
+		fprintf( stderr, "Failed to allocate output buffer.\n" );
+		free( input );
+
+		return 1;
+	}
+
+	RunConfig config = { .max_to_print = max_to_print, .format = format, .out = out, .verify = verify, .threads = threads, .key_range = key_range, .pattern = pattern, .large = large };
+
+	if ( schedule_mode ) {
+		lengths[ 0 ] = input ? array_length : lengths[ 0 ]; // Each job clamps max_to_print to its own length.
+		bool ok = run_scheduled( args, lengths, input ? 1 : length_count, seeds, input ? 1 : seed_count, input, skip_siblings, &config );
+		fast_writer_delete( &out );
+		free( input );
+		input = NULL;
+
+		return ok ? 0 : 1;
 	}
 
-	// Quicksort (stack).
-	if ( set_member( args, F_QUICK_STACK ) || set_member( args, F_ALL ) ) {
-		if ( !run_and_print_sort( "Quicksort (Stack)", quicksort_stack, array_length, random_seed, max_to_print ) ) {
+	// Set max_to_print to the number of elements to print.
+	config.max_to_print = max_to_print < array_length ? max_to_print : array_length;
+
+	if ( verify ) { // Hash the input once for every sort to be checked against.
+		config.input_hash = verify_multiset_hash( input, array_length, threads );
+	}
+
+	if ( trace_records > 0 ) {
+		config.trace = partition_trace_create( trace_records );
+
+		if ( !config.trace ) {
+			fprintf( stderr, "Failed to allocate partition trace.\n" );
+			fast_writer_delete( &out );
+			free( input );
+
 			return 1;
 		}
+
+		quick_set_trace( config.trace );
 	}
 
-	// Quicksort (queue).
-	if ( set_member( args, F_QUICK_QUEUE ) || set_member( args, F_ALL ) ) {
-		if ( !run_and_print_sort( "Quicksort (Queue)", quicksort_queue, array_length, random_seed, max_to_print ) ) {
-			return 1;
+	bool ok = true;
+
+	bubble_set_thread_count( threads );
+	quick_set_thread_count( threads );
+	argsort_set_thread_count( threads );
+
+	for ( uint32_t i = 0; ok && i < SORT_COUNT; i++ ) {
+		if ( set_member( args, sorts[ i ].flag ) || set_member( args, F_ALL ) ) {
+			ok = run_and_print_sort( sorts[ i ].name, sorts[ i ].sort_function, input, array_length, &config );
 		}
 	}
 
-	return 0;
+	// Quicksort with duplicate removal.
+	if ( ok && set_member( args, F_UNIQUE ) ) {
+		ok = run_fused_dedup( "Quicksort (Unique Keys)", input, array_length, false, &config );
+	}
+
+	// Quicksort with key counts.
+	if ( ok && set_member( args, F_COUNTS ) ) {
+		ok = run_fused_dedup( "Quicksort (Key Counts)", input, array_length, true, &config );
+	}
+
+	// Incremental merge of appended batches.
+	if ( ok && set_member( args, F_INCREMENTAL_MERGE ) ) {
+		merge_set_thread_count( threads );
+		ok = run_incremental_merge( input, array_length, batch_size, &config );
+	}
+
+	quick_set_trace( NULL );
+	partition_trace_delete( &config.trace );
+	fast_writer_delete( &out );
+	free( input );
+	input = NULL;
+
+	return ok ? 0 : 1;
 }
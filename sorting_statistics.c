@@ -6,11 +6,11 @@
 // Initializes a SortingStatistics struct with a specified number of elements being sorted.
 //
 // Parameters:
-// uint32_t elements - The number of elements being sorted.
+// uint64_t elements - The number of elements being sorted.
 //
 // Returns:
 // SortingStatistics - An initialized SortingStatistics struct.
-SortingStatistics sorting_statistics_create( uint32_t elements ) {
+SortingStatistics sorting_statistics_create( uint64_t elements ) {
 	SortingStatistics stats;
 	stats.elements = elements;
 	stats.moves = 0;
@@ -6,12 +6,12 @@
 typedef struct SortingStatistics SortingStatistics;
 
 struct SortingStatistics {
-	uint32_t elements; // Number of elements processed.
+	uint64_t elements; // Number of elements processed.
 	uint64_t moves; // Number of moves done by the sort.
 	uint64_t compares; // Number of compares done by the sort.
-	uint32_t max_ds_size; // The max size of the backing data structure of the sorting algorithm. (only used by quicksort)
+	uint64_t max_ds_size; // The max size of the backing data structure of the sorting algorithm. (only used by quicksort)
 };
 
-SortingStatistics sorting_statistics_create( uint32_t elements );
+SortingStatistics sorting_statistics_create( uint64_t elements );
 
 #endif
@@ -1,6 +1,9 @@
 #include "stack.h"
 
+#include "huge_alloc.h"
+
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -8,12 +11,12 @@
 // A struct for the Stack ADT.
 //
 // Members:
-// uint32_t top - Index of the next empty slot in the stack.
-// uint32_t capacity - Capacity of the stack.
+// size_t top - Index of the next empty slot in the stack.
+// size_t capacity - Capacity of the stack.
 // int64_t *items - Holds the items.
 struct Stack {
-	uint32_t top;
-	uint32_t capacity;
+	size_t top;
+	size_t capacity;
 	int64_t *items;
 };
 
@@ -21,17 +24,17 @@ struct Stack {
 // Initializes a stack with a specified capacity.
 //
 // Parameters:
-// uint32_t capacity - The max capacity of the stack.
+// size_t capacity - The max capacity of the stack.
 //
 // Returns:
 // Stack * - A pointer to the newly initialized stack.
-Stack *stack_create( uint32_t capacity ) {
+Stack *stack_create( size_t capacity ) {
 	Stack *s = ( Stack * ) malloc( sizeof( Stack ) );
 
 	if ( s ) { // Make sure the memory allocated successfully to the struct.
 		s->top = 0;
 		s->capacity = capacity;
-		s->items = ( int64_t * ) calloc( capacity, sizeof( int64_t ) );
+		s->items = capacity <= SIZE_MAX / sizeof( int64_t ) ? ( int64_t * ) huge_alloc( capacity * sizeof( int64_t ) ) : NULL;
 
 		if ( !s->items ) { // s->items could not be allocated memory.
 			free( s );
@@ -52,7 +55,7 @@ Stack *stack_create( uint32_t capacity ) {
 // Nothing.
 void stack_delete( Stack **s ) {
 	if ( *s && ( *s )->items ) { // Make sure the stack wasn't already deleted.
-		free( ( *s )->items );
+		huge_free( ( *s )->items, ( *s )->capacity * sizeof( int64_t ) );
 		free( *s );
 		*s = NULL;
 	}
@@ -89,8 +92,8 @@ bool stack_full( Stack *s ) {
 // Stack *s - The stack to check.
 //
 // Returns:
-// uint32_t - The size of the stack.
-uint32_t stack_size( Stack *s ) {
+// size_t - The size of the stack.
+size_t stack_size( Stack *s ) {
 	return s->top;
 }
 
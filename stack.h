@@ -2,11 +2,12 @@
 #define __STACK_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct Stack Stack;
 
-Stack *stack_create( uint32_t capacity );
+Stack *stack_create( size_t capacity );
 
 void stack_delete( Stack **s );
 
@@ -14,7 +15,7 @@ bool stack_empty( Stack *s );
 
 bool stack_full( Stack *s );
 
-uint32_t stack_size( Stack *s );
+size_t stack_size( Stack *s );
 
 bool stack_push( Stack *s, int64_t x );
 
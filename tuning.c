@@ -0,0 +1,154 @@
+#include "tuning.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKEN_LENGTH 64 // The max length of a key or value in a profile file.
+
+static TuningProfile active_profile;
+static pthread_once_t active_profile_once = PTHREAD_ONCE_INIT;
+
+// Description:
+// Returns the profile that reproduces the untuned behavior of the sorts.
+//
+// Parameters:
+// Nothing.
+//
+// Returns:
+// TuningProfile - The default profile.
+TuningProfile tuning_defaults( ) {
+	TuningProfile profile;
+	profile.small_sort_cutoff = 0;
+	profile.pivot = PIVOT_MIDDLE;
+	profile.gaps = GAP_SEQ_CIURA;
+	profile.threads = 1;
+	profile.parallel_threshold = 0;
+
+	return profile;
+}
+
+// Description:
+// Reads a profile from a file of "key value" lines. Keys that are missing keep their default values.
+//
+// Parameters:
+// const char *path - The path to the profile file.
+// TuningProfile *profile - A pointer to the TuningProfile to fill in.
+//
+// Returns:
+// bool - Whether the operation was successful (false if the file could not be opened or has an invalid line).
+bool tuning_load( const char *path, TuningProfile *profile ) {
+	FILE *file = fopen( path, "r" );
+
+	if ( !file ) {
+		return false;
+	}
+
+	TuningProfile loaded = tuning_defaults( );
+	char key[ MAX_TOKEN_LENGTH ];
+	char value[ MAX_TOKEN_LENGTH ];
+	bool ok = true;
+
+	while ( ok && fscanf( file, "%63s %63s", key, value ) == 2 ) {
+		if ( strcmp( key, "small_sort_cutoff" ) == 0 ) {
+			loaded.small_sort_cutoff = strtoul( value, NULL, 10 );
+		} else if ( strcmp( key, "pivot" ) == 0 ) {
+			ok = strcmp( value, "middle" ) == 0 || strcmp( value, "median_of_three" ) == 0;
+			loaded.pivot = strcmp( value, "median_of_three" ) == 0 ? PIVOT_MEDIAN_OF_THREE : PIVOT_MIDDLE;
+		} else if ( strcmp( key, "gap_sequence" ) == 0 ) {
+			ok = strcmp( value, "ciura" ) == 0 || strcmp( value, "pratt" ) == 0;
+			loaded.gaps = strcmp( value, "pratt" ) == 0 ? GAP_SEQ_PRATT : GAP_SEQ_CIURA;
+		} else if ( strcmp( key, "threads" ) == 0 ) {
+			loaded.threads = strtoul( value, NULL, 10 );
+			loaded.threads = loaded.threads > 0 ? loaded.threads : 1;
+		} else if ( strcmp( key, "parallel_threshold" ) == 0 ) {
+			loaded.parallel_threshold = strtoul( value, NULL, 10 );
+		} else { // Unknown key.
+			ok = false;
+		}
+	}
+
+	ok = ok && feof( file );
+	fclose( file );
+
+	if ( ok ) {
+		*profile = loaded;
+	}
+
+	return ok;
+}
+
+// Description:
+// Writes a profile to a file of "key value" lines that tuning_load( ) can read.
+//
+// Parameters:
+// const char *path - The path to the profile file.
+// const TuningProfile *profile - A pointer to the TuningProfile to write.
+//
+// Returns:
+// bool - Whether the operation was successful.
+bool tuning_save( const char *path, const TuningProfile *profile ) {
+	FILE *file = fopen( path, "w" );
+
+	if ( !file ) {
+		return false;
+	}
+
+	fprintf( file, "small_sort_cutoff %" PRIu32 "\n", profile->small_sort_cutoff );
+	fprintf( file, "pivot %s\n", profile->pivot == PIVOT_MEDIAN_OF_THREE ? "median_of_three" : "middle" );
+	fprintf( file, "gap_sequence %s\n", profile->gaps == GAP_SEQ_PRATT ? "pratt" : "ciura" );
+	fprintf( file, "threads %" PRIu32 "\n", profile->threads );
+	fprintf( file, "parallel_threshold %" PRIu32 "\n", profile->parallel_threshold );
+
+	bool ok = !ferror( file );
+
+	return fclose( file ) == 0 && ok;
+}
+
+// Description:
+// Loads the active profile from the file named by TUNING_PROFILE_ENV, or uses the defaults if it is unset.
+//
+// Parameters:
+// Nothing.
+//
+// Returns:
+// Nothing.
+static void load_active_profile( ) {
+	active_profile = tuning_defaults( );
+	const char *path = getenv( TUNING_PROFILE_ENV );
+
+	if ( path && !tuning_load( path, &active_profile ) ) {
+		fprintf( stderr, "Failed to load tuning profile %s, using defaults.\n", path );
+	}
+}
+
+// Description:
+// Gets the active profile. The profile is loaded the first time this is called.
+//
+// Parameters:
+// Nothing.
+//
+// Returns:
+// const TuningProfile * - A pointer to the active profile.
+const TuningProfile *tuning_get( ) {
+	pthread_once( &active_profile_once, load_active_profile );
+
+	return &active_profile;
+}
+
+// Description:
+// Replaces the active profile, for example to benchmark a candidate setting. No sort may be running.
+//
+// Parameters:
+// const TuningProfile *profile - A pointer to the new profile.
+//
+// Returns:
+// Nothing.
+void tuning_set( const TuningProfile *profile ) {
+	pthread_once( &active_profile_once, load_active_profile );
+	active_profile = *profile;
+}
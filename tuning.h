@@ -0,0 +1,35 @@
+#ifndef __TUNING_H__
+#define __TUNING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TUNING_PROFILE_ENV "SORTING_PROFILE" // The environment variable holding the path of the profile to load.
+
+// An enum for the ways quicksort can pick a pivot.
+typedef enum { PIVOT_MIDDLE, PIVOT_MEDIAN_OF_THREE } pivot_strategy;
+
+// An enum for the gap sequences shell sort can use when none has been set.
+typedef enum { GAP_SEQ_CIURA, GAP_SEQ_PRATT } gap_sequence;
+
+typedef struct TuningProfile TuningProfile;
+
+struct TuningProfile {
+	uint32_t small_sort_cutoff; // Quicksort ranges with at most this many elements are insertion sorted (0 = never).
+	pivot_strategy pivot; // How quicksort picks a pivot.
+	gap_sequence gaps; // The gap sequence shell sort uses when none has been set.
+	uint32_t threads; // The default number of threads for parallel sorts.
+	uint32_t parallel_threshold; // Multi-threaded sorts use one thread for arrays with fewer elements than this.
+};
+
+TuningProfile tuning_defaults( );
+
+bool tuning_load( const char *path, TuningProfile *profile );
+
+bool tuning_save( const char *path, const TuningProfile *profile );
+
+const TuningProfile *tuning_get( );
+
+void tuning_set( const TuningProfile *profile );
+
+#endif
@@ -0,0 +1,217 @@
+#include "verify.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SORTED_BLOCK 1024 // The number of pairs checked between early exits, small enough to stay in L1.
+#define MIX_SEED_A   0x9E3779B97F4A7C15ULL // Seeds that make the two mixes of a multiset hash independent.
+#define MIX_SEED_B   0xD1B54A32D192ED03ULL
+
+// Description:
+// A slice of an array checked by one thread.
+//
+// Members:
+// const uint32_t *arr - The array to check.
+// uint32_t lo - The first index of the slice.
+// uint32_t hi - One past the last index of the slice.
+// bool sorted - Set to whether the slice is sorted (for verify_sorted( )).
+// MultisetHash hash - Set to the hash of the slice (for verify_multiset_hash( )).
+typedef struct {
+	const uint32_t *arr;
+	uint32_t lo;
+	uint32_t hi;
+	bool sorted;
+	MultisetHash hash;
+} VerifyTask;
+
+// Description:
+// Mixes a 64-bit value so that every input bit affects every output bit (the SplitMix64 finalizer).
+//
+// Parameters:
+// uint64_t x - The value to mix.
+//
+// Returns:
+// uint64_t - The mixed value.
+static inline uint64_t mix( uint64_t x ) {
+	x = ( x ^ ( x >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	x = ( x ^ ( x >> 27 ) ) * 0x94D049BB133111EBULL;
+
+	return x ^ ( x >> 31 );
+}
+
+// Description:
+// Runs a function on contiguous slices of an array, one slice per thread. The calling thread
+// takes the first slice, and slices whose thread cannot be started are run on the calling thread.
+//
+// Parameters:
+// void *( *fn )( void * ) - The function to run on each VerifyTask.
+// const uint32_t *arr - The array to split.
+// uint32_t len - The length of the array.
+// uint32_t threads - The number of slices.
+// VerifyTask *tasks - Space for threads tasks, filled in with the slices and their results.
+//
+// Returns:
+// Nothing.
+static void run_slices( void *( *fn )( void * ), const uint32_t *arr, uint32_t len, uint32_t threads, VerifyTask *tasks ) {
+	pthread_t *handles = ( pthread_t * ) calloc( threads, sizeof( pthread_t ) );
+	bool *started = ( bool * ) calloc( threads, sizeof( bool ) );
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		tasks[ t ].arr = arr;
+		tasks[ t ].lo = ( uint32_t ) ( ( uint64_t ) len * t / threads );
+		tasks[ t ].hi = ( uint32_t ) ( ( uint64_t ) len * ( t + 1 ) / threads );
+	}
+
+	for ( uint32_t t = 1; handles && started && t < threads; t++ ) {
+		started[ t ] = pthread_create( &handles[ t ], NULL, fn, &tasks[ t ] ) == 0;
+	}
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		if ( started && started[ t ] ) {
+			pthread_join( handles[ t ], NULL );
+		} else {
+			fn( &tasks[ t ] );
+		}
+	}
+
+	free( handles );
+	free( started );
+}
+
+// Description:
+// Checks that each element of a slice is no greater than the element after it. Each block of pairs is checked
+// without branching so that it vectorizes, and the check stops at the first unsorted block.
+//
+// Parameters:
+// void *arg - A pointer to the VerifyTask. The slice's last element is compared to the element after the slice.
+//
+// Returns:
+// void * - NULL.
+static void *check_sorted_slice( void *arg ) {
+	VerifyTask *task = ( VerifyTask * ) arg;
+	task->sorted = true;
+
+	for ( uint32_t i = task->lo; i < task->hi && task->sorted; i += SORTED_BLOCK ) {
+		uint32_t end = task->hi - i < SORTED_BLOCK ? task->hi : i + SORTED_BLOCK;
+		uint32_t unsorted = 0;
+
+		for ( uint32_t j = i; j < end; j++ ) {
+			unsorted |= task->arr[ j ] > task->arr[ j + 1 ];
+		}
+
+		task->sorted = !unsorted;
+	}
+
+	return NULL;
+}
+
+// Description:
+// Hashes the elements of a slice.
+//
+// Parameters:
+// void *arg - A pointer to the VerifyTask.
+//
+// Returns:
+// void * - NULL.
+static void *hash_slice( void *arg ) {
+	VerifyTask *task = ( VerifyTask * ) arg;
+	uint64_t sum_a = 0;
+	uint64_t sum_b = 0;
+
+	for ( uint32_t i = task->lo; i < task->hi; i++ ) {
+		sum_a += mix( task->arr[ i ] ^ MIX_SEED_A );
+		sum_b += mix( task->arr[ i ] ^ MIX_SEED_B );
+	}
+
+	task->hash.sum_a = sum_a;
+	task->hash.sum_b = sum_b;
+
+	return NULL;
+}
+
+// Description:
+// Checks whether an array is sorted in non-decreasing order, split across threads.
+//
+// Parameters:
+// const uint32_t *arr - The array to check.
+// uint32_t len - The length of the array.
+// uint32_t threads - The number of threads to use.
+//
+// Returns:
+// bool - Whether the array is sorted.
+bool verify_sorted( const uint32_t *arr, uint32_t len, uint32_t threads ) {
+	if ( len < 2 ) {
+		return true;
+	}
+
+	threads = threads > 0 ? threads : 1;
+	VerifyTask *tasks = ( VerifyTask * ) calloc( threads, sizeof( VerifyTask ) );
+
+	if ( !tasks ) { // Check on this thread alone.
+		VerifyTask task = { .arr = arr, .lo = 0, .hi = len - 1 };
+		check_sorted_slice( &task );
+
+		return task.sorted;
+	}
+
+	run_slices( check_sorted_slice, arr, len - 1, threads, tasks ); // There are len - 1 pairs to check.
+	bool sorted = true;
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		sorted = sorted && tasks[ t ].sorted;
+	}
+
+	free( tasks );
+
+	return sorted;
+}
+
+// Description:
+// Computes an order-independent hash of the elements of an array, split across threads. Two arrays that are
+// permutations of each other always have the same hash, and other arrays almost never do.
+//
+// Parameters:
+// const uint32_t *arr - The array to hash.
+// uint32_t len - The length of the array.
+// uint32_t threads - The number of threads to use.
+//
+// Returns:
+// MultisetHash - The hash of the array.
+MultisetHash verify_multiset_hash( const uint32_t *arr, uint32_t len, uint32_t threads ) {
+	threads = threads > 0 ? threads : 1;
+	VerifyTask *tasks = ( VerifyTask * ) calloc( threads, sizeof( VerifyTask ) );
+
+	if ( !tasks ) { // Hash on this thread alone.
+		VerifyTask task = { .arr = arr, .lo = 0, .hi = len };
+		hash_slice( &task );
+
+		return task.hash;
+	}
+
+	run_slices( hash_slice, arr, len, threads, tasks );
+	MultisetHash hash = { 0, 0 };
+
+	for ( uint32_t t = 0; t < threads; t++ ) {
+		hash.sum_a += tasks[ t ].hash.sum_a;
+		hash.sum_b += tasks[ t ].hash.sum_b;
+	}
+
+	free( tasks );
+
+	return hash;
+}
+
+// Description:
+// Checks whether two multiset hashes are equal.
+//
+// Parameters:
+// MultisetHash a - The first hash.
+// MultisetHash b - The second hash.
+//
+// Returns:
+// bool - Whether the hashes are equal.
+bool verify_same_multiset( MultisetHash a, MultisetHash b ) {
+	return a.sum_a == b.sum_a && a.sum_b == b.sum_b;
+}
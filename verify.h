@@ -0,0 +1,20 @@
+#ifndef __VERIFY_H__
+#define __VERIFY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct MultisetHash MultisetHash;
+
+struct MultisetHash {
+	uint64_t sum_a; // Sum of one mix of every element (wrapping).
+	uint64_t sum_b; // Sum of a second, independent mix of every element (wrapping).
+};
+
+bool verify_sorted( const uint32_t *arr, uint32_t len, uint32_t threads );
+
+MultisetHash verify_multiset_hash( const uint32_t *arr, uint32_t len, uint32_t threads );
+
+bool verify_same_multiset( MultisetHash a, MultisetHash b );
+
+#endif